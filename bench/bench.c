@@ -0,0 +1,1796 @@
+//
+// Headless stress-scene benchmark
+//
+// Runs the simulation systems from src/world.c over a set of standard scenes
+// for a fixed number of ticks and prints per-system ns/entity and total
+// ticks/sec as JSON on stdout. No window is opened and raylib is never linked
+// - only its headers are used for the types and raymath.
+//
+// build and run from the repo root with `make bench`
+//
+
+#include "raylib.h"
+#include "raymath.h"
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "arena.c"
+#include "pool.c"
+#include "atomic_arena.c"
+#include "containers.c"
+#include "string_builder.c"
+#include "compress.c"
+#include "noise.c"
+#include "world.c"
+#include "animation.c"
+#include "tilemap.c"
+#include "worldgen.c"
+#include "streaming.c"
+#include "save.c"
+#include "autosave.c"
+#include "rewind.c"
+
+#define BENCH_ARENA_RESERVE_SIZE GB(4)
+#define BENCH_DEFAULT_TICKS 600
+
+const float benchDeltaT = 1.0f / 60.0f;
+#define BENCH_WORLD_SEED 1234
+
+uint64_t bench_now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// For keeping the fastest of several timed samples
+uint64_t bench_min_ns(uint64_t a, uint64_t b) { return a < b ? a : b; }
+
+// Deterministic so every run spawns the same scene
+uint32_t bench_rng_state = 1;
+uint32_t bench_rand() {
+  uint32_t x = bench_rng_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  bench_rng_state = x;
+  return x;
+}
+
+// Reads the width/height out of a PNG's IHDR chunk so entity bounds match
+// the game without loading any textures
+Texture2D LoadSpriteSize(char *path) {
+  Texture2D sprite = {0};
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return sprite;
+  }
+  unsigned char header[24];
+  if (fread(header, 1, sizeof(header), file) == sizeof(header)) {
+    sprite.width = (header[16] << 24) | (header[17] << 16) |
+                   (header[18] << 8) | header[19];
+    sprite.height = (header[20] << 24) | (header[21] << 16) |
+                    (header[22] << 8) | header[23];
+  }
+  fclose(file);
+  return sprite;
+}
+
+// Only the systems that scale with the entity count are timed one by one.
+// The clock, player movement and camera touch the player alone - a few ns a
+// tick, below the timer's own noise - so they're only in the total.
+typedef enum BenchSystem {
+  system_harvest = 0,
+  system_pickup,
+  system_animation,
+  SYSTEM_MAX
+} BenchSystem;
+char *systemNames[SYSTEM_MAX] = {"harvest", "pickup", "animation"};
+
+typedef struct Scene {
+  char *name;
+  int rocks;
+  int weeds;
+  int items;
+  int harvestEvery; // ticks between clicks, 0 never clicks
+  bool denseGrid;   // pack entities into every tile instead of scattering
+  bool itemsOnPath; // line the items up along the player's walk
+} Scene;
+
+Scene scenes[] = {
+    {.name = "rocks_weeds_1k", .rocks = 500, .weeds = 500, .harvestEvery = 8},
+    {.name = "rocks_weeds_10k",
+     .rocks = 5000,
+     .weeds = 5000,
+     .harvestEvery = 8},
+    {.name = "rocks_weeds_100k",
+     .rocks = 50000,
+     .weeds = 50000,
+     .harvestEvery = 8},
+    {.name = "harvest_heavy",
+     .rocks = 5000,
+     .weeds = 5000,
+     .harvestEvery = 1,
+     .denseGrid = true},
+    {.name = "pickup_heavy",
+     .rocks = 1000,
+     .items = 10000,
+     .harvestEvery = 0,
+     .itemsOnPath = true},
+};
+#define SCENE_COUNT (int)(sizeof(scenes) / sizeof(scenes[0]))
+
+typedef struct SceneResult {
+  int entities;
+  size_t arenaHighWater;
+  uint64_t systemNs[SYSTEM_MAX];
+  uint64_t totalNs;
+} SceneResult;
+
+// Tile coordinates of the n-th slot of a square grid centred on the player
+Vector2 GridTile(int n, int side) {
+  int x = n % side - side / 2;
+  int y = n / side - side / 2;
+  return Vector2Add(world->player->pos, v2(x * tileWidth, y * tileWidth));
+}
+
+void SpawnScene(Scene *scene) {
+  int statics = scene->rocks + scene->weeds;
+  // scattered scenes keep roughly one entity per four tiles at every size
+  int side = (int)ceilf(sqrtf(statics * (scene->denseGrid ? 1.0f : 4.0f)));
+  if (side < 1) {
+    side = 1;
+  }
+
+  for (int i = 0; i < statics; i++) {
+    int slot = scene->denseGrid ? i : (int)(bench_rand() % (side * side));
+    Vector2 pos = GridTile(slot, side);
+    if (i < scene->rocks) {
+      SetupRock(pos);
+    } else {
+      SetupWeed(pos);
+    }
+  }
+
+  for (int i = 0; i < scene->items; i++) {
+    Vector2 pos;
+    if (scene->itemsOnPath) {
+      // one item per tile to the right of the player plus a row above and
+      // below that is never reached, so the scan cost stays in the numbers
+      int row = i % 3 - 1;
+      pos = Vector2Add(world->player->pos,
+                       v2((i / 3) * tileWidth, row * tileWidth * 4));
+    } else {
+      pos = GridTile(bench_rand() % (side * side), side);
+    }
+    SetupItemWood(pos);
+  }
+}
+
+SceneResult RunScene(Arena *arena, Scene *scene, int ticks) {
+  SceneResult result = {0};
+
+  arena_free_all(arena);
+  memset(&arena->stats, 0, sizeof(arena->stats));
+  world = arena_alloc_tagged(arena, sizeof(World), arena_tag_world);
+  InitWorld(world);
+  world->state = state_play;
+  bench_rng_state = 1;
+  SpawnScene(scene);
+
+  for (int i = 0; i < world->entityHighWater; i++) {
+    result.entities += world->entities[i].is_valid;
+  }
+
+  int gridSide = (int)ceilf(sqrtf(scene->rocks + scene->weeds));
+  if (gridSide < 1) {
+    gridSide = 1;
+  }
+
+  uint64_t sceneStart = bench_now_ns();
+  for (int tick = 0; tick < ticks; tick++) {
+    // keep the player alive for however many ticks we run
+    world->energy = 100;
+    UpdateClock(world, benchDeltaT);
+    UpdatePlayerMovement(world, v2(1, 0), benchDeltaT);
+    UpdateCameraCenterSmoothFollow(&world->camera, world->player, benchDeltaT,
+                                   world->screenWidth, world->screenHeight);
+    uint64_t t0 = bench_now_ns();
+    if (scene->harvestEvery && tick % scene->harvestEvery == 0) {
+      // sweep the cursor across the grid, hitting each tile three times
+      Vector2 tile = round_v2_to_tile(
+          GridTile((tick / scene->harvestEvery / 3) % (gridSide * gridSide),
+                   gridSide));
+      UpdateHarvest(world, (Rectangle){tile.x, tile.y, tileWidth, tileWidth});
+    }
+    uint64_t t1 = bench_now_ns();
+    UpdatePickup(world);
+    uint64_t t2 = bench_now_ns();
+    UpdateAnimation(world, tick * benchDeltaT);
+    UpdateSpriteAnimation(world, benchDeltaT);
+    uint64_t t3 = bench_now_ns();
+
+    result.systemNs[system_harvest] += t1 - t0;
+    result.systemNs[system_pickup] += t2 - t1;
+    result.systemNs[system_animation] += t3 - t2;
+  }
+  result.totalNs = bench_now_ns() - sceneStart;
+  result.arenaHighWater = arena->stats.high_water;
+
+  return result;
+}
+
+// Large-buffer allocation throughput - allocate, overwrite the whole buffer
+// as a sprintf target or pixel upload would, then give it back. Reported in
+// GB/s of buffer. fresh_pages maps a new reserved arena each time so the
+// allocation lands on never-touched pages the arena knows are already zero.
+double BenchArenaAlloc(Arena *arena, size_t size, ArenaFlags flags,
+                       bool fresh_pages, int iterations) {
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < iterations; i++) {
+    Arena fresh = {0};
+    Arena *target = arena;
+    if (fresh_pages) {
+      if (!arena_init_reserve(&fresh, size)) {
+        return 0;
+      }
+      target = &fresh;
+    }
+    Temp_Arena_Memory tmp = temp_arena_memory_begin(target);
+    unsigned char *buffer =
+        arena_alloc_align_flags(target, size, DEFAULT_ALIGNMENT,
+                                arena_tag_untagged, flags);
+    if (!buffer) {
+      return 0;
+    }
+    memset(buffer, 0xab, size);
+    temp_arena_memory_end(tmp);
+    if (fresh_pages) {
+      arena_release(&fresh);
+    }
+  }
+  double seconds = (bench_now_ns() - start) / 1e9;
+  return (double)size * iterations / seconds / 1e9;
+}
+
+void PrintArenaBench(Arena *arena) {
+  size_t sizes[] = {MB(1), MB(16)};
+  int iterations[] = {256, 16};
+  char *sizeNames[] = {"1mb", "16mb"};
+
+  printf("  \"arena\": {");
+  for (int i = 0; i < 2; i++) {
+    arena_free_all(arena);
+    double zero = BenchArenaAlloc(arena, sizes[i], arena_flags_none, false,
+                                  iterations[i]);
+    double nozero = BenchArenaAlloc(arena, sizes[i], arena_flag_no_zero,
+                                    false, iterations[i]);
+    double fresh = BenchArenaAlloc(arena, sizes[i], arena_flags_none, true,
+                                   iterations[i]);
+    printf("%s\n    \"alloc_%s_zero_gb_per_s\": %.2f,\n", i ? "," : "",
+           sizeNames[i], zero);
+    printf("    \"alloc_%s_nozero_gb_per_s\": %.2f,\n", sizeNames[i], nozero);
+    printf("    \"alloc_%s_fresh_pages_gb_per_s\": %.2f", sizeNames[i],
+           fresh);
+  }
+  // a reset hands everything past the retained size back to the OS
+  arena_free_all(arena);
+  if (arena->committed > ARENA_RETAIN_COMMITTED) {
+    fprintf(stderr, "arena bench: %zu bytes still committed after a reset\n",
+            arena->committed);
+    exit(1);
+  }
+  printf("\n  },\n");
+}
+
+// Churn workload - a live set of small objects where every op frees a
+// random one and allocates a replacement, like dropped items or particles
+#define CHURN_LIVE 10000
+#define CHURN_OPS 1000000
+#define CHURN_OBJECT_SIZE 48
+
+typedef struct ChurnObject {
+  unsigned char bytes[CHURN_OBJECT_SIZE];
+} ChurnObject;
+POOL_DEFINE(ChurnObject, ChurnPool, churn_pool)
+
+void PrintPoolBench(Arena *arena) {
+  ChurnObject **live = malloc(CHURN_LIVE * sizeof(ChurnObject *));
+
+  arena_free_all(arena);
+  ChurnPool pool;
+  if (!churn_pool_init(&pool, arena, CHURN_LIVE, true)) {
+    free(live);
+    return;
+  }
+
+  bench_rng_state = 1;
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < CHURN_LIVE; i++) {
+    live[i] = churn_pool_alloc(&pool);
+  }
+  for (int i = 0; i < CHURN_OPS; i++) {
+    int slot = bench_rand() % CHURN_LIVE;
+    churn_pool_free(&pool, live[slot]);
+    live[slot] = churn_pool_alloc(&pool);
+    live[slot]->bytes[0] = (unsigned char)i;
+  }
+  double poolNs = (double)(bench_now_ns() - start) / CHURN_OPS;
+
+  // walk the occupancy bitmap - what iterating live items would cost
+  start = bench_now_ns();
+  long visited = 0;
+  for (long i = pool_next_occupied(&pool.pool, 0); i >= 0;
+       i = pool_next_occupied(&pool.pool, i + 1)) {
+    visited += churn_pool_at(&pool, i)->bytes[0] != 0xff;
+  }
+  double iterateNs = (double)(bench_now_ns() - start) / (visited ? visited : 1);
+
+  // same workload through malloc, zeroed to match pool_alloc
+  bench_rng_state = 1;
+  start = bench_now_ns();
+  for (int i = 0; i < CHURN_LIVE; i++) {
+    live[i] = calloc(1, sizeof(ChurnObject));
+  }
+  for (int i = 0; i < CHURN_OPS; i++) {
+    int slot = bench_rand() % CHURN_LIVE;
+    free(live[slot]);
+    live[slot] = calloc(1, sizeof(ChurnObject));
+    live[slot]->bytes[0] = (unsigned char)i;
+  }
+  double mallocNs = (double)(bench_now_ns() - start) / CHURN_OPS;
+  for (int i = 0; i < CHURN_LIVE; i++) {
+    free(live[i]);
+  }
+  free(live);
+
+  printf("  \"pool\": {\n");
+  printf("    \"churn_pool_ns_per_op\": %.2f,\n", poolNs);
+  printf("    \"churn_malloc_ns_per_op\": %.2f,\n", mallocNs);
+  printf("    \"iterate_ns_per_item\": %.2f,\n", iterateNs);
+  printf("    \"peak_in_use\": %zu\n", pool.pool.stats.peak_in_use);
+  printf("  },\n");
+}
+
+// Worker scratch allocation - every thread makes many small allocations at
+// once, either straight off the shared atomic offset, from its own
+// ThreadArena, or through malloc
+#define WORKER_THREADS 4
+#define WORKER_ALLOCS 250000
+
+typedef enum WorkerMode {
+  worker_atomic,
+  worker_thread_arena,
+  worker_malloc,
+} WorkerMode;
+
+typedef struct WorkerJob {
+  AtomicArena *shared;
+  WorkerMode mode;
+  size_t failed;
+} WorkerJob;
+
+void *RunWorkerJob(void *arg) {
+  WorkerJob *job = arg;
+  ThreadArena local;
+  thread_arena_init(&local, job->shared, KB(64));
+  for (int i = 0; i < WORKER_ALLOCS; i++) {
+    size_t size = 16 + (i & 63);
+    unsigned char *p = NULL;
+    if (job->mode == worker_atomic) {
+      p = atomic_arena_alloc_nozero(job->shared, size);
+    } else if (job->mode == worker_thread_arena) {
+      p = thread_arena_alloc_nozero(&local, size);
+    } else {
+      p = malloc(size);
+    }
+    if (!p) {
+      job->failed++;
+      continue;
+    }
+    p[0] = (unsigned char)i;
+    // the malloc run frees as it goes so it doesn't just measure page faults
+    if (job->mode == worker_malloc) {
+      free(p);
+    }
+  }
+  return NULL;
+}
+
+double BenchWorkers(AtomicArena *shared, WorkerMode mode) {
+  pthread_t threads[WORKER_THREADS];
+  WorkerJob jobs[WORKER_THREADS];
+  atomic_arena_reset(shared);
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < WORKER_THREADS; i++) {
+    jobs[i] = (WorkerJob){.shared = shared, .mode = mode};
+    pthread_create(&threads[i], NULL, RunWorkerJob, &jobs[i]);
+  }
+  for (int i = 0; i < WORKER_THREADS; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  uint64_t elapsed = bench_now_ns() - start;
+  for (int i = 0; i < WORKER_THREADS; i++) {
+    if (jobs[i].failed) {
+      fprintf(stderr, "worker bench: %zu allocations failed\n",
+              jobs[i].failed);
+    }
+  }
+  return (double)elapsed / ((double)WORKER_THREADS * WORKER_ALLOCS);
+}
+
+void PrintThreadsBench(Arena *arena) {
+  arena_free_all(arena);
+  AtomicArena shared;
+  // worst case: every allocation rounded up to the atomic alignment
+  if (!atomic_arena_init(&shared, arena,
+                         (size_t)WORKER_THREADS * WORKER_ALLOCS *
+                             ATOMIC_ARENA_ALIGNMENT * 2)) {
+    return;
+  }
+  // an untimed pass first so no run pays for faulting the pages in - the
+  // reset before this section handed them back to the OS
+  BenchWorkers(&shared, worker_atomic);
+  double atomicNs = BenchWorkers(&shared, worker_atomic);
+  double threadNs = BenchWorkers(&shared, worker_thread_arena);
+  double mallocNs = BenchWorkers(&shared, worker_malloc);
+
+  printf("  \"threads\": {\n");
+  printf("    \"workers\": %d,\n", WORKER_THREADS);
+  printf("    \"atomic_ns_per_alloc\": %.2f,\n", atomicNs);
+  printf("    \"thread_arena_ns_per_alloc\": %.2f,\n", threadNs);
+  printf("    \"malloc_ns_per_alloc\": %.2f\n", mallocNs);
+  printf("  },\n");
+}
+
+// Lookup cost at the sizes we expect (inventories up to chunk tables),
+// hash map against a linear scan of a dynamic array
+DARRAY_DEFINE(int, IntArray, int_array)
+HASHMAP_DEFINE(int, int, IntMap, int_map, hash_int, eq_int)
+
+#define LOOKUPS 200000
+#define LOOKUP_RUNS 5
+
+void PrintContainersBench(Arena *arena) {
+  int sizes[] = {8, 32, 128, 1024};
+  printf("  \"containers\": {");
+  for (int s = 0; s < 4; s++) {
+    int size = sizes[s];
+    arena_free_all(arena);
+    IntArray keys;
+    IntMap map;
+    // the map is initialised small so the bench also covers growth
+    int_array_init(&keys, arena, 0);
+    int_map_init(&map, arena, 0);
+    bench_rng_state = 1;
+    for (int i = 0; i < size; i++) {
+      int key = (int)(bench_rand() & 0x7fffffff);
+      int_array_append(&keys, key);
+      *int_map_put(&map, key) = i;
+    }
+    if (map.count != (size_t)size) {
+      // a repeated random key - doesn't happen with this seed
+      fprintf(stderr, "containers bench: duplicate keys\n");
+    }
+
+    long found = 0;
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < LOOKUPS; i++) {
+      int key = keys.items[(i * 7919) % size];
+      for (size_t k = 0; k < keys.count; k++) {
+        if (keys.items[k] == key) {
+          found += k;
+          break;
+        }
+      }
+    }
+    double linearNs = (double)(bench_now_ns() - start) / LOOKUPS;
+
+    // the best of a few passes - one pass is ~2ms, short enough that a
+    // single preemption moves it by tens of percent
+    long mapFound = 0;
+    double mapNs = 0;
+    for (int run = 0; run < LOOKUP_RUNS; run++) {
+      mapFound = 0;
+      start = bench_now_ns();
+      for (int i = 0; i < LOOKUPS; i++) {
+        int *value = int_map_get(&map, keys.items[(i * 7919) % size]);
+        if (value) {
+          mapFound += *value;
+        }
+      }
+      double ns = (double)(bench_now_ns() - start) / LOOKUPS;
+      if (run == 0 || ns < mapNs) {
+        mapNs = ns;
+      }
+    }
+
+    if (found != mapFound) {
+      fprintf(stderr, "containers bench: map and scan disagree\n");
+      exit(1);
+    }
+
+    printf("%s\n    \"lookup_%d_linear_ns_per_op\": %.2f,\n", s ? "," : "",
+           size, linearNs);
+    printf("    \"lookup_%d_hashmap_ns_per_op\": %.2f", size, mapNs);
+  }
+  printf("\n  },\n");
+}
+
+// HUD text formatting - a frame's worth of short lines through arena_printf
+// against the old fixed stack buffer + sprintf, plus the string builder
+#define STRING_LINES 200000
+#define STRING_RUNS 5
+
+void PrintStringsBench(Arena *arena) {
+  char expected[64];
+  arena_free_all(arena);
+  uint64_t start = bench_now_ns();
+  size_t totalLength = 0;
+  for (int i = 0; i < STRING_LINES; i++) {
+    char line[1000];
+    sprintf(line, "Day %d, %02d:%02d", i / 1440 + 1, (i / 60) % 24, i % 60);
+    totalLength += strlen(line);
+  }
+  double stackNs = (double)(bench_now_ns() - start) / STRING_LINES;
+
+  // Each timed loop is a few tens of ms - the best of STRING_RUNS, with the
+  // arena rewound in between so later runs reuse the same pages
+  char *first = NULL;
+  double arenaNs = 0;
+  for (int run = 0; run < STRING_RUNS; run++) {
+    Temp_Arena_Memory tmp = temp_arena_memory_begin(arena);
+    first = NULL;
+    start = bench_now_ns();
+    for (int i = 0; i < STRING_LINES; i++) {
+      char *line =
+          arena_printf_tagged(arena, arena_tag_hud, "Day %d, %02d:%02d",
+                              i / 1440 + 1, (i / 60) % 24, i % 60);
+      if (!first) {
+        first = line;
+      }
+    }
+    double ns = (double)(bench_now_ns() - start) / STRING_LINES;
+    if (run == 0 || ns < arenaNs) {
+      arenaNs = ns;
+    }
+    if (run + 1 < STRING_RUNS) {
+      temp_arena_memory_end(tmp);
+    }
+  }
+
+  // The lines are packed back to back, each with its terminator
+  char *line = first;
+  for (int i = 0; i < STRING_LINES; i++) {
+    snprintf(expected, sizeof(expected), "Day %d, %02d:%02d", i / 1440 + 1,
+             (i / 60) % 24, i % 60);
+    if (!line || strcmp(line, expected) != 0) {
+      fprintf(stderr, "strings bench: arena_printf mismatch at %d\n", i);
+      exit(1);
+    }
+    line += strlen(line) + 1;
+  }
+
+  arena_free_all(arena);
+  double builderNs = 0;
+  for (int run = 0; run < STRING_RUNS; run++) {
+    Temp_Arena_Memory tmp = temp_arena_memory_begin(arena);
+    start = bench_now_ns();
+    for (int i = 0; i < STRING_LINES / 100; i++) {
+      StringBuilder sb;
+      sb_init(&sb, arena, arena_tag_hud, 0);
+      for (int part = 0; part < 100; part++) {
+        sb_appendf(&sb, "%s: %d\n", getArchetypeName(part % ARCH_MAX), part);
+      }
+      if (sb.length != strlen(sb.data)) {
+        fprintf(stderr, "strings bench: builder length mismatch\n");
+        exit(1);
+      }
+    }
+    double ns = (double)(bench_now_ns() - start) / STRING_LINES;
+    if (run == 0 || ns < builderNs) {
+      builderNs = ns;
+    }
+    temp_arena_memory_end(tmp);
+  }
+
+  printf("  \"strings\": {\n");
+  printf("    \"stack_sprintf_ns_per_line\": %.2f,\n", stackNs);
+  printf("    \"arena_printf_ns_per_line\": %.2f,\n", arenaNs);
+  printf("    \"builder_ns_per_append\": %.2f,\n", builderNs);
+  printf("    \"bytes_formatted\": %zu\n", totalLength);
+  printf("  },\n");
+}
+
+// Item bob animation over a world full of dropped items, the vector pass
+// against one sin per entity. Also checks the two agree.
+#define ANIMATION_ITEMS 100000
+#define ANIMATION_FRAMES 100
+
+void PrintAnimationBench(Arena *arena) {
+  arena_free_all(arena);
+  world = arena_alloc_tagged(arena, sizeof(World), arena_tag_world);
+  InitWorld(world);
+  for (int i = 0; i < ANIMATION_ITEMS; i++) {
+    SetupItemWood(GridTile(i, 400));
+    // spread the phases so the check covers the angle-sum path
+    entity_set_bob(&world->entities[world->entityHighWater - 1],
+                   itemBobHeight, (i % 64) * 0.1f);
+  }
+  int count = world->entityHighWater;
+
+  // Each is the fastest frame - one frame is a few hundred us, short
+  // enough that the average over all of them follows the machine's load
+  uint64_t best = UINT64_MAX;
+  for (int frame = 0; frame < ANIMATION_FRAMES; frame++) {
+    uint64_t start = bench_now_ns();
+    UpdateAnimationScalar(world, frame * benchDeltaT);
+    best = bench_min_ns(best, bench_now_ns() - start);
+  }
+  double scalarNs = (double)best / count;
+  float *expected = arena_alloc_nozero(arena, sizeof(float) * count);
+  memcpy(expected, world->bobOffset, sizeof(float) * count);
+
+  best = UINT64_MAX;
+  for (int frame = 0; frame < ANIMATION_FRAMES; frame++) {
+    uint64_t start = bench_now_ns();
+    UpdateAnimation(world, frame * benchDeltaT);
+    best = bench_min_ns(best, bench_now_ns() - start);
+  }
+  double vectorNs = (double)best / count;
+
+  for (int i = 0; i < count; i++) {
+    if (fabsf(world->bobOffset[i] - expected[i]) > 1e-3f) {
+      fprintf(stderr, "animation bench: entity %d %f != %f\n", i,
+              world->bobOffset[i], expected[i]);
+      exit(1);
+    }
+  }
+
+  // Sprite frame selection over the same number of swaying weeds
+  arena_free_all(arena);
+  world = arena_alloc_tagged(arena, sizeof(World), arena_tag_world);
+  InitWorld(world);
+  for (int i = 0; i < ANIMATION_ITEMS; i++) {
+    SetupWeed(GridTile(i, 400));
+  }
+  count = world->entityHighWater;
+  best = UINT64_MAX;
+  for (int frame = 0; frame < ANIMATION_FRAMES; frame++) {
+    uint64_t start = bench_now_ns();
+    UpdateSpriteAnimation(world, benchDeltaT);
+    best = bench_min_ns(best, bench_now_ns() - start);
+  }
+  double framesNs = (double)best / count;
+
+  AnimClip sway = animClips[clip_weed_sway];
+  for (int i = 0; i < count; i++) {
+    if (world->animClip[i] == clip_none) {
+      continue; // the player, standing still
+    }
+    float elapsed = world->animClock - world->animStart[i];
+    uint16_t expected = sway.firstFrame +
+                        (unsigned)(elapsed * sway.fps) % sway.frameCount;
+    if (world->animFrame[i] != expected) {
+      fprintf(stderr, "animation bench: entity %d on frame %d not %d\n", i,
+              world->animFrame[i], expected);
+      exit(1);
+    }
+  }
+
+  printf("  \"animation\": {\n");
+  printf("    \"scalar_ns_per_entity\": %.3f,\n", scalarNs);
+  printf("    \"vector_ns_per_entity\": %.3f,\n", vectorNs);
+  printf("    \"sprite_frames_ns_per_entity\": %.3f\n", framesNs);
+  printf("  },\n");
+}
+
+// Noise kernels - fractal value noise a row at a time in each instruction
+// set the CPU has, checked against the scalar reference
+#define NOISE_SIDE 256
+#define NOISE_OCTAVES 4
+#define NOISE_PASSES 4
+
+void PrintNoiseBench(Arena *arena) {
+  arena_free_all(arena);
+  size_t samples = NOISE_SIDE * NOISE_SIDE;
+  float *reference = arena_alloc_nozero(arena, samples * sizeof(float));
+  float *out = arena_alloc_nozero(arena, samples * sizeof(float));
+  const float scale = 1.0f / 24;
+  // spans negative and positive lattice coordinates
+  const int originX = -NOISE_SIDE / 2;
+  const int originY = -NOISE_SIDE / 3;
+
+  printf("  \"noise\": {\n");
+  printf("    \"best_isa\": \"%s\"", noiseIsaNames[noise_best_isa()]);
+  for (int isa = 0; isa < NOISE_ISA_MAX; isa++) {
+    if (!noise_isa_supported(isa)) {
+      continue;
+    }
+    float *dest = isa == noise_isa_scalar ? reference : out;
+    uint64_t start = bench_now_ns();
+    for (int pass = 0; pass < NOISE_PASSES; pass++) {
+      for (int y = 0; y < NOISE_SIDE; y++) {
+        fbm_noise_row_isa(isa, BENCH_WORLD_SEED, originX, originY + y, scale,
+                          NOISE_SIDE, NOISE_OCTAVES, &dest[y * NOISE_SIDE]);
+      }
+    }
+    double seconds = (bench_now_ns() - start) / 1e9;
+
+    for (size_t i = 0; i < samples; i++) {
+      int x = originX + (int)(i % NOISE_SIDE);
+      int y = originY + (int)(i / NOISE_SIDE);
+      float expected = fbm_noise(BENCH_WORLD_SEED, (float)x * scale,
+                                 (float)y * scale, NOISE_OCTAVES);
+      if (dest[i] != expected) {
+        fprintf(stderr, "noise bench: %s gave %.9g at %d,%d, not %.9g\n",
+                noiseIsaNames[isa], dest[i], x, y, expected);
+        exit(1);
+      }
+    }
+    printf(",\n    \"%s_samples_per_sec\": %.0f", noiseIsaNames[isa],
+           samples * NOISE_PASSES / seconds);
+  }
+  printf("\n  },\n");
+}
+
+// Ground tile map on the CPU - filling the index window when the camera
+// changes chunk, and the reference renderer for the ground shader at the
+// low resolution target's size
+#define GROUND_WIDTH 256
+#define GROUND_HEIGHT 144
+#define GROUND_FILLS 20
+#define GROUND_RENDERS 20
+
+void PrintGroundBench(Arena *arena) {
+  arena_free_all(arena);
+  GroundWindow *window =
+      arena_alloc_tagged(arena, sizeof(GroundWindow), arena_tag_world);
+  Color *pixels = arena_alloc_nozero(arena, sizeof(Color) * GROUND_WIDTH *
+                                                GROUND_HEIGHT);
+
+  uint64_t start = bench_now_ns();
+  for (int i = 0; i < GROUND_FILLS; i++) {
+    UpdateGroundWindow(window, BENCH_WORLD_SEED, (ChunkCoord){i, -i}, NULL);
+  }
+  double fillNs = (double)(bench_now_ns() - start) /
+                  (GROUND_FILLS * GROUND_WINDOW_TILES * GROUND_WINDOW_TILES);
+
+  for (int y = 0; y < GROUND_WINDOW_TILES; y++) {
+    for (int x = 0; x < GROUND_WINDOW_TILES; x++) {
+      if (window->indices[y * GROUND_WINDOW_TILES + x] !=
+          GroundTileAt(BENCH_WORLD_SEED, window->originX + x,
+                       window->originY + y)) {
+        fprintf(stderr, "ground bench: window tile %d,%d is wrong\n", x, y);
+        exit(1);
+      }
+    }
+  }
+
+  // One pixel per tileset texel with the view's top left on a tile corner,
+  // so every pixel's expected texel is known exactly
+  Camera2D camera = {0};
+  camera.zoom = 1.0f / spriteScale;
+  camera.target = v2((window->originX + 3) * tileWidth,
+                     (window->originY + 5) * tileWidth);
+  start = bench_now_ns();
+  for (int i = 0; i < GROUND_RENDERS; i++) {
+    RenderGroundCPU(window, pixels, GROUND_WIDTH, GROUND_HEIGHT, camera);
+  }
+  double renderNs = (double)(bench_now_ns() - start) /
+                    (GROUND_RENDERS * GROUND_WIDTH * GROUND_HEIGHT);
+
+  for (int y = 0; y < GROUND_HEIGHT; y++) {
+    for (int x = 0; x < GROUND_WIDTH; x++) {
+      GroundTile tile =
+          GroundTileAt(BENCH_WORLD_SEED,
+                       window->originX + 3 + x / GROUND_TILE_TEXELS,
+                       window->originY + 5 + y / GROUND_TILE_TEXELS);
+      Color expected = GroundTilesetTexel(tile, x % GROUND_TILE_TEXELS,
+                                          y % GROUND_TILE_TEXELS);
+      Color got = pixels[y * GROUND_WIDTH + x];
+      if (memcmp(&expected, &got, sizeof(Color)) != 0) {
+        fprintf(stderr, "ground bench: pixel %d,%d is wrong\n", x, y);
+        exit(1);
+      }
+    }
+  }
+
+  printf("  \"ground\": {\n");
+  printf("    \"window_fill_ns_per_tile\": %.2f,\n", fillNs);
+  printf("    \"cpu_render_ns_per_pixel\": %.2f\n", renderNs);
+  printf("  },\n");
+}
+
+// World generation - populating chunks as they come near the camera, and
+// checks that a chunk is the same whatever order it's generated in
+#define WORLDGEN_SIDE 8 // chunks per side of the generated block
+
+World *WorldGenBenchWorld(Arena *arena) {
+  world = arena_alloc_tagged(arena, sizeof(World), arena_tag_world);
+  InitWorld(world);
+  world->seed = BENCH_WORLD_SEED;
+  if (!chunk_table_init(&world->chunks, arena, 64)) {
+    fprintf(stderr, "worldgen bench: out of memory\n");
+    exit(1);
+  }
+  return world;
+}
+
+// Order independent digest of what was spawned from a chunk's tiles
+uint64_t WorldGenChunkDigest(World *world, ChunkCoord coord) {
+  uint64_t digest = 0;
+  for (int i = 1; i < world->entityHighWater; i++) { // 0 is the player
+    Entity *entity = &world->entities[i];
+    if (entity->is_valid && chunk_coord_eq(entity_chunk(entity), coord)) {
+      uint32_t x, y;
+      memcpy(&x, &entity->pos.x, sizeof(x));
+      memcpy(&y, &entity->pos.y, sizeof(y));
+      digest += hash_u64(((uint64_t)x << 32 | y) ^ entity->archetype);
+    }
+  }
+  return digest;
+}
+
+void PrintWorldGenBench(Arena *arena) {
+  arena_free_all(arena);
+  World *all = WorldGenBenchWorld(arena);
+  // away from the player so the spawn clearance doesn't skew the count
+  ChunkCoord origin = {4, -4};
+  uint64_t start = bench_now_ns();
+  for (int y = 0; y < WORLDGEN_SIDE; y++) {
+    for (int x = 0; x < WORLDGEN_SIDE; x++) {
+      GenerateChunk(all, (ChunkCoord){origin.x + x, origin.y + y});
+    }
+  }
+  int chunks = WORLDGEN_SIDE * WORLDGEN_SIDE;
+  double chunkNs = (double)(bench_now_ns() - start) / chunks;
+  double entitiesPerChunk = (double)(all->entityHighWater - 1) / chunks;
+
+  ChunkCoord probe = {origin.x + 5, origin.y + 2};
+  uint64_t expected = WorldGenChunkDigest(all, probe);
+  World *one = WorldGenBenchWorld(arena);
+  GenerateChunk(one, probe);
+  if (expected == 0 || WorldGenChunkDigest(one, probe) != expected) {
+    fprintf(stderr, "worldgen bench: chunk %d,%d depends on its neighbours\n",
+            probe.x, probe.y);
+    exit(1);
+  }
+  // Everything spawned from the chunk has to be attributed back to it, and
+  // so do items dropped on its edge tiles
+  float left = tile_pos_to_world_pos(probe.x * CHUNK_TILES);
+  float top = tile_pos_to_world_pos(probe.y * CHUNK_TILES);
+  float far = tile_pos_to_world_pos(CHUNK_TILES - 1);
+  for (int t = 0; t < CHUNK_TILES; t++) {
+    float along = tile_pos_to_world_pos(t);
+    SetupItemWood(v2(left + far, top + along));
+    SetupItemBerry(v2(left, top + along));
+    SetupItemWood(v2(left + along, top));
+    SetupItemBerry(v2(left + along, top + far));
+  }
+  for (int i = 1; i < one->entityHighWater; i++) {
+    ChunkCoord coord = entity_chunk(&one->entities[i]);
+    if (!chunk_coord_eq(coord, probe)) {
+      fprintf(stderr, "worldgen bench: entity %d of chunk %d,%d is in %d,%d\n",
+              i, probe.x, probe.y, coord.x, coord.y);
+      exit(1);
+    }
+  }
+
+  World *lazy = WorldGenBenchWorld(arena);
+  int first = UpdateWorldGen(lazy);
+  int second = UpdateWorldGen(lazy);
+  int side = 2 * WORLDGEN_RADIUS_CHUNKS + 1;
+  if (first != side * side || second != 0) {
+    fprintf(stderr, "worldgen bench: generated %d then %d chunks\n", first,
+            second);
+    exit(1);
+  }
+
+  printf("  \"worldgen\": {\n");
+  printf("    \"entities_per_chunk\": %.1f,\n", entitiesPerChunk);
+  printf("    \"ns_per_chunk\": %.0f\n", chunkNs);
+  printf("  },\n");
+}
+
+// Chunk streaming - the lock-free queue on its own, then a walk across the
+// map with the worker generating ahead. The walk checks that what streamed
+// in matches generating inline and that nothing far behind is left loaded.
+#define SPSC_ITEMS 1000000
+#define SPSC_RUNS 5
+#define STREAM_WALK_TICKS 600
+#define STREAM_WALK_STEP 20.0f // px per tick, ~9 chunks over the walk
+#define STREAM_TICK_SLEEP_NS 200000
+#define STREAM_MODIFIED_WALK_TICKS 1800 // ~28 chunks, over the pool's 128
+
+void *SpscProducer(void *arg) {
+  SpscQueue *q = arg;
+  for (uintptr_t i = 1; i <= SPSC_ITEMS; i++) {
+    while (!spsc_queue_push(q, (void *)i)) {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+// One producer thread hands SPSC_ITEMS pointers to this one, returns ns each
+double BenchSpscQueue(Arena *arena) {
+  Temp_Arena_Memory tmp = temp_arena_memory_begin(arena);
+  SpscQueue queue;
+  if (!spsc_queue_init(&queue, arena, 1024)) {
+    return 0;
+  }
+  pthread_t producer;
+  uint64_t start = bench_now_ns();
+  pthread_create(&producer, NULL, SpscProducer, &queue);
+  for (uintptr_t expected = 1; expected <= SPSC_ITEMS;) {
+    void *item = spsc_queue_pop(&queue);
+    if (!item) {
+      sched_yield();
+      continue;
+    }
+    if ((uintptr_t)item != expected) {
+      fprintf(stderr, "streaming bench: queue gave %zu, expected %zu\n",
+              (size_t)(uintptr_t)item, (size_t)expected);
+      exit(1);
+    }
+    expected++;
+  }
+  pthread_join(producer, NULL);
+  double ns = (double)(bench_now_ns() - start) / SPSC_ITEMS;
+  temp_arena_memory_end(tmp);
+  return ns;
+}
+
+void PrintStreamingBench(Arena *arena) {
+  arena_free_all(arena);
+  // the fastest of a few runs - how the two threads land on cores swings a
+  // single run by 2-3x, the best one is the queue's own cost
+  double spscNs = 0;
+  for (int run = 0; run < SPSC_RUNS; run++) {
+    double ns = BenchSpscQueue(arena);
+    if (ns <= 0) {
+      return;
+    }
+    if (run == 0 || ns < spscNs) {
+      spscNs = ns;
+    }
+  }
+
+  static Streamer streamer;
+  if (!InitStreamer(&streamer, arena) || !streamer.running) {
+    fprintf(stderr, "streaming bench: no worker thread\n");
+    exit(1);
+  }
+  World *walk = WorldGenBenchWorld(arena);
+  ResetStreamer(&streamer, walk);
+  struct timespec frame = {0, STREAM_TICK_SLEEP_NS};
+  uint64_t integrateNs = 0;
+  uint64_t worstNs = 0;
+  for (int tick = 0; tick < STREAM_WALK_TICKS; tick++) {
+    walk->player->pos.x += STREAM_WALK_STEP;
+    walk->camera.target = walk->player->pos;
+    UpdateStreaming(&streamer, walk, benchDeltaT);
+    integrateNs += streamer.integrateNs;
+    if (streamer.integrateNs > worstNs) {
+      worstNs = streamer.integrateNs;
+    }
+    nanosleep(&frame, NULL);
+  }
+  // stand still until the worker has caught up
+  while (streamer.inFlight > 0) {
+    UpdateStreaming(&streamer, walk, benchDeltaT);
+    integrateNs += streamer.integrateNs;
+    nanosleep(&frame, NULL);
+  }
+  int spawned = streamer.spawned;
+  int dropped = streamer.dropped;
+  int unloaded = streamer.unloaded;
+
+  ChunkCoord center = chunk_of(walk->player->pos);
+  for (int i = 1; i < walk->entityHighWater; i++) {
+    Entity *entity = &walk->entities[i];
+    if (entity->is_valid &&
+        chunk_ring_distance(entity_chunk(entity), center) >
+            STREAM_UNLOAD_RADIUS + 1) {
+      fprintf(stderr, "streaming bench: entity %d left behind\n", i);
+      exit(1);
+    }
+  }
+  for (int dy = -STREAM_LOAD_RADIUS; dy <= STREAM_LOAD_RADIUS; dy++) {
+    for (int dx = -STREAM_LOAD_RADIUS; dx <= STREAM_LOAD_RADIUS; dx++) {
+      ChunkCoord coord = {center.x + dx, center.y + dy};
+      ChunkInfo *info = chunk_table_get(&walk->chunks, coord);
+      if (!info || info->state != chunk_loaded) {
+        fprintf(stderr, "streaming bench: chunk %d,%d never loaded\n",
+                coord.x, coord.y);
+        exit(1);
+      }
+      if (dy == 0) {
+        continue; // on the player's path - the spawn clearance differs
+      }
+      uint64_t streamed = WorldGenChunkDigest(walk, coord);
+      World *inline_ = WorldGenBenchWorld(arena);
+      GenerateChunk(inline_, coord);
+      uint64_t expected = WorldGenChunkDigest(inline_, coord);
+      world = walk;
+      if (streamed != expected) {
+        fprintf(stderr, "streaming bench: chunk %d,%d differs from inline\n",
+                coord.x, coord.y);
+        exit(1);
+      }
+    }
+  }
+
+  // Keep walking, changing every chunk as it loads, past the point where
+  // the changed chunks alone would need more blocks than the pool has. New
+  // terrain must still stream in, and only chunks inside the unload ring
+  // may hold on to their ChunkData.
+  for (int tick = 0; tick < STREAM_MODIFIED_WALK_TICKS || streamer.inFlight;
+       tick++) {
+    if (tick < STREAM_MODIFIED_WALK_TICKS) {
+      walk->player->pos.x += STREAM_WALK_STEP;
+      walk->camera.target = walk->player->pos;
+    }
+    UpdateStreaming(&streamer, walk, benchDeltaT);
+    for (size_t i = 0; i < walk->chunks.capacity; i++) {
+      ChunkTableEntry *entry = &walk->chunks.entries[i];
+      if (entry->hash && entry->value.state == chunk_loaded) {
+        entry->value.modified = true;
+      }
+    }
+    nanosleep(&frame, NULL);
+  }
+  UnloadStreamer(&streamer);
+  center = chunk_of(walk->player->pos);
+  for (int dy = -STREAM_LOAD_RADIUS; dy <= STREAM_LOAD_RADIUS; dy++) {
+    for (int dx = -STREAM_LOAD_RADIUS; dx <= STREAM_LOAD_RADIUS; dx++) {
+      ChunkCoord coord = {center.x + dx, center.y + dy};
+      ChunkInfo *info = chunk_table_get(&walk->chunks, coord);
+      if (!info || info->state != chunk_loaded || !info->data) {
+        fprintf(stderr, "streaming bench: chunk %d,%d never loaded after "
+                        "%d changed chunks\n",
+                coord.x, coord.y, (int)walk->chunks.count);
+        exit(1);
+      }
+    }
+  }
+  for (size_t i = 0; i < walk->chunks.capacity; i++) {
+    ChunkTableEntry *entry = &walk->chunks.entries[i];
+    if (entry->hash && entry->value.data &&
+        chunk_ring_distance(entry->key, center) > STREAM_UNLOAD_RADIUS) {
+      fprintf(stderr, "streaming bench: chunk %d,%d still holds its data\n",
+              entry->key.x, entry->key.y);
+      exit(1);
+    }
+  }
+  if (walk->chunks.count <= STREAM_MAX_CHUNKS) {
+    fprintf(stderr, "streaming bench: only %d chunks changed\n",
+            (int)walk->chunks.count);
+    exit(1);
+  }
+
+  printf("  \"streaming\": {\n");
+  printf("    \"spsc_ns_per_item\": %.2f,\n", spscNs);
+  printf("    \"chunks_spawned\": %d,\n", spawned);
+  printf("    \"chunks_dropped\": %d,\n", dropped);
+  printf("    \"chunks_unloaded\": %d,\n", unloaded);
+  printf("    \"integrate_ns_per_chunk\": %.0f,\n",
+         (double)integrateNs / (spawned ? spawned : 1));
+  printf("    \"worst_frame_integrate_us\": %.1f\n", worstNs / 1e3);
+  printf("  },\n");
+}
+
+// Save files - a large World written out and mapped back in. Checks the
+// round trip gives back the same World and that a save from a different
+// version is refused.
+#define SAVE_BENCH_ENTITIES 60000
+#define SAVE_BENCH_PATH "bin/bench_save.sav"
+#define SAVE_BENCH_BAD_PATH "bin/bench_save_bad.sav"
+
+void PrintSaveBench(Arena *arena) {
+  arena_free_all(arena);
+  GameMemory memory;
+  if (!InitGameMemory(&memory) || !StartSession(&memory, BENCH_WORLD_SEED)) {
+    fprintf(stderr, "save bench: out of memory\n");
+    exit(1);
+  }
+  UpdateWorldGen(world);
+  for (int n = world->entityHighWater; n < SAVE_BENCH_ENTITIES; n++) {
+    if (n % 2) {
+      SetupItemBerry(GridTile(n, 300));
+    } else {
+      SetupRock(GridTile(n, 300));
+    }
+  }
+  for (int i = 0; i < MAX_INVENTORY_COUNT; i++) {
+    world->inventory[i] = i * 3;
+  }
+  world->timeInMinutes = 1234;
+  world->timeElapsed = 5678.5;
+  world->dayCount = 9;
+  world->player->pos = v2(-321, 654);
+  ChunkCoord requested = {40, 40};
+  chunk_table_put(&world->chunks, requested)->state = chunk_requested;
+  ChunkCoord modified = chunk_of(world->player->pos);
+  chunk_table_put(&world->chunks, modified)->modified = true;
+
+  World *before = arena_alloc_nozero(arena, sizeof(World));
+  memcpy(before, world, sizeof(World));
+  ptrdiff_t playerIndex = world->player - world->entities;
+  // the session arena is reset by the load
+  ChunkTable chunksBefore = world->chunks;
+  size_t chunkBytes = chunksBefore.capacity * sizeof(ChunkTableEntry);
+  chunksBefore.entries = arena_alloc_nozero(arena, chunkBytes);
+  memcpy(chunksBefore.entries, world->chunks.entries, chunkBytes);
+
+  uint64_t start = bench_now_ns();
+  if (!SaveGame(world, &memory.frame[0], SAVE_BENCH_PATH)) {
+    fprintf(stderr, "save bench: couldn't write %s\n", SAVE_BENCH_PATH);
+    exit(1);
+  }
+  double saveMs = (bench_now_ns() - start) / 1e6;
+  if (memcmp(before, world, sizeof(World)) != 0) {
+    fprintf(stderr, "save bench: saving changed the World\n");
+    exit(1);
+  }
+  struct stat info;
+  stat(SAVE_BENCH_PATH, &info);
+
+  // The same save from another version or with a broken chunk table must
+  // be refused, World untouched
+  FILE *file = fopen(SAVE_BENCH_PATH, "rb");
+  unsigned char *bytes = arena_alloc_nozero(arena, info.st_size);
+  if (!file || fread(bytes, 1, info.st_size, file) != (size_t)info.st_size) {
+    fprintf(stderr, "save bench: couldn't read %s back\n", SAVE_BENCH_PATH);
+    exit(1);
+  }
+  fclose(file);
+  World *current = world;
+  SaveHeader *header = (SaveHeader *)bytes;
+  for (int bad = 0; bad < 2; bad++) {
+    if (bad == 0) {
+      header->version = SAVE_VERSION + 1;
+    } else {
+      // an empty chunk table passes the power of two check on its own
+      header->version = SAVE_VERSION;
+      header->chunkCapacity = 0;
+    }
+    file = fopen(SAVE_BENCH_BAD_PATH, "wb");
+    fwrite(bytes, 1, info.st_size, file);
+    fclose(file);
+    if (LoadGame(&memory, SAVE_BENCH_BAD_PATH) || world != current) {
+      fprintf(stderr, "save bench: loaded a save with %s\n",
+              bad ? "no chunk table" : "another version");
+      exit(1);
+    }
+  }
+  unlink(SAVE_BENCH_BAD_PATH);
+
+  start = bench_now_ns();
+  World *loaded = LoadGame(&memory, SAVE_BENCH_PATH);
+  double loadMs = (bench_now_ns() - start) / 1e6;
+  if (!loaded || loaded != world) {
+    fprintf(stderr, "save bench: couldn't load %s\n", SAVE_BENCH_PATH);
+    exit(1);
+  }
+  // pages are only read in as they're touched - time the first full pass
+  start = bench_now_ns();
+  bool same =
+      memcmp(loaded->entities, before->entities, sizeof(before->entities)) ==
+          0 &&
+      memcmp(loaded->inventory, before->inventory,
+             sizeof(before->inventory)) == 0;
+  double touchMs = (bench_now_ns() - start) / 1e6;
+  same = same && loaded->timeInMinutes == before->timeInMinutes &&
+         loaded->timeElapsed == before->timeElapsed &&
+         loaded->dayCount == before->dayCount &&
+         loaded->seed == before->seed &&
+         loaded->entityHighWater == before->entityHighWater &&
+         loaded->player - loaded->entities == playerIndex &&
+         loaded->chunks.count == chunksBefore.count;
+  for (size_t i = 0; same && i < chunksBefore.capacity; i++) {
+    ChunkTableEntry *entry = &chunksBefore.entries[i];
+    if (!entry->hash) {
+      continue;
+    }
+    ChunkInfo *info = chunk_table_get(&loaded->chunks, entry->key);
+    uint8_t state = entry->value.state == chunk_requested
+                        ? chunk_unloaded
+                        : entry->value.state;
+    same = info && info->state == state &&
+           info->modified == entry->value.modified && !info->data;
+  }
+  if (!same) {
+    fprintf(stderr, "save bench: the loaded World differs from the saved\n");
+    exit(1);
+  }
+  // and it's playable - new chunks go in the session arena
+  for (int i = 0; i < 200; i++) {
+    if (!chunk_table_put(&loaded->chunks, (ChunkCoord){-100 - i, 100})) {
+      fprintf(stderr, "save bench: loaded chunk table can't grow\n");
+      exit(1);
+    }
+  }
+
+  ReleaseLoadedSave();
+  ReleaseGameMemory(&memory);
+  world = NULL;
+  unlink(SAVE_BENCH_PATH);
+
+  printf("  \"save\": {\n");
+  printf("    \"entities\": %d,\n", before->entityHighWater);
+  printf("    \"file_kb\": %lld,\n", (long long)info.st_size / 1024);
+  printf("    \"save_ms\": %.2f,\n", saveMs);
+  printf("    \"load_ms\": %.3f,\n", loadMs);
+  printf("    \"first_pass_ms\": %.2f\n", touchMs);
+  printf("  },\n");
+}
+
+// Autosave - a few chunks changed in a big World. Staging is the part the
+// game thread waits on, so it's compared with writing the whole World on
+// this thread and with the pause to fork a child that writes it. An autosave
+// with nothing changed must stage nothing.
+#define AUTOSAVE_BENCH_DIR "bin/bench_autosave"
+#define AUTOSAVE_BENCH_BAD_DIR "bin/bench_missing/autosave"
+#define AUTOSAVE_BENCH_CHANGED 4 // chunks the player harvests in
+#define AUTOSAVE_BENCH_FORK_PATH "bin/bench_fork.sav"
+#define AUTOSAVE_BENCH_FORKS 5
+
+void PrintAutosaveBench(Arena *arena) {
+  arena_free_all(arena);
+  GameMemory memory;
+  static Autosaver autosaver;
+  if (!InitGameMemory(&memory) || !StartSession(&memory, BENCH_WORLD_SEED) ||
+      !InitAutosaver(&autosaver, arena, AUTOSAVE_BENCH_DIR)) {
+    fprintf(stderr, "autosave bench: out of memory\n");
+    exit(1);
+  }
+  ChunkCoord origin = {4, -4};
+  for (int y = 0; y < WORLDGEN_SIDE; y++) {
+    for (int x = 0; x < WORLDGEN_SIDE; x++) {
+      ChunkCoord coord = {origin.x + x, origin.y + y};
+      GenerateChunk(world, coord);
+      chunk_table_put(&world->chunks, coord)->state = chunk_loaded;
+    }
+  }
+  for (int n = world->entityHighWater; n < SAVE_BENCH_ENTITIES; n++) {
+    SetupRock(GridTile(n, 300));
+  }
+
+  // Harvest a few things in each changed chunk, dropping items
+  for (int c = 0; c < AUTOSAVE_BENCH_CHANGED; c++) {
+    ChunkCoord coord = {origin.x + 1 + c, origin.y + 2 * c};
+    int harvested = 0;
+    for (int i = 1; i < world->entityHighWater && harvested < 5; i++) {
+      Entity *entity = &world->entities[i];
+      if (entity->is_valid && entity->is_destroyable_world_item &&
+          chunk_coord_eq(entity_chunk(entity), coord)) {
+        world_mark_chunk_modified(entity);
+        entity_destroy(entity);
+        SetupItemWood(entity->pos);
+        harvested++;
+      }
+    }
+  }
+  world->inventory[arch_item_wood] = 7;
+  world->player->pos = v2(-123, 456);
+
+  int modified = 0;
+  uint64_t digests[AUTOSAVE_MAX_CHUNKS];
+  ChunkCoord coords[AUTOSAVE_MAX_CHUNKS];
+  for (size_t i = 0; i < world->chunks.capacity; i++) {
+    ChunkTableEntry *entry = &world->chunks.entries[i];
+    if (entry->hash && entry->value.modified) {
+      coords[modified] = entry->key;
+      digests[modified] = WorldGenChunkDigest(world, entry->key);
+      modified++;
+    }
+  }
+
+  // A directory that can't be made fails every write - the chunks must be
+  // staged again next time
+  struct timespec wait = {0, 100000};
+  snprintf(autosaver.dir, sizeof(autosaver.dir), "%s", AUTOSAVE_BENCH_BAD_DIR);
+  StageAutosave(&autosaver, world);
+  while (AutosaveBusy(&autosaver)) {
+    nanosleep(&wait, NULL);
+  }
+  if (autosaver.chunksWritten != 0 || autosaver.failures == 0) {
+    fprintf(stderr, "autosave bench: wrote into %s\n", AUTOSAVE_BENCH_BAD_DIR);
+    exit(1);
+  }
+  snprintf(autosaver.dir, sizeof(autosaver.dir), "%s", AUTOSAVE_BENCH_DIR);
+  autosaver.failures = 0;
+
+  if (!StageAutosave(&autosaver, world)) {
+    fprintf(stderr, "autosave bench: the writer was busy\n");
+    exit(1);
+  }
+  uint64_t stageNs = autosaver.stageNs;
+  int staged = autosaver.stagedChunks;
+  while (AutosaveBusy(&autosaver)) {
+    nanosleep(&wait, NULL);
+  }
+  uint64_t writeNs = autosaver.writeNs;
+  uint64_t bytes = autosaver.bytesWritten;
+  if (modified < AUTOSAVE_BENCH_CHANGED || staged != modified ||
+      autosaver.chunksWritten != modified || autosaver.failures) {
+    fprintf(stderr, "autosave bench: wrote %d of %d changed chunks\n",
+            autosaver.chunksWritten, modified);
+    exit(1);
+  }
+  StageAutosave(&autosaver, world);
+  if (autosaver.stagedChunks != 0) {
+    fprintf(stderr, "autosave bench: staged %d unchanged chunks\n",
+            autosaver.stagedChunks);
+    exit(1);
+  }
+
+  // The whole World on this thread, then from a forked child - the two
+  // files must be the same. The game forks with a full rewind ring resident,
+  // so the bench does too.
+  static Rewind history;
+  if (!InitRewind(&history, arena)) {
+    fprintf(stderr, "autosave bench: out of memory\n");
+    exit(1);
+  }
+  memset(history.buffer, 0, REWIND_BUFFER_SIZE);
+  uint64_t start = bench_now_ns();
+  SaveGame(world, &memory.frame[0], SAVE_BENCH_PATH);
+  double fullMs = (bench_now_ns() - start) / 1e6;
+  // The best of a few forks - now and then one takes several times as long
+  // for reasons outside the process (the kernel reclaiming, another load)
+  uint64_t forkPauseNs = UINT64_MAX;
+  uint64_t forkNs = UINT64_MAX;
+  for (int run = 0; run < AUTOSAVE_BENCH_FORKS; run++) {
+    if (!ForkAutosave(&autosaver, world, AUTOSAVE_BENCH_FORK_PATH)) {
+      fprintf(stderr, "autosave bench: couldn't fork\n");
+      exit(1);
+    }
+    ReapAutosaveChild(&autosaver, true);
+    forkPauseNs = bench_min_ns(forkPauseNs, autosaver.forkPauseNs);
+    forkNs = bench_min_ns(forkNs, autosaver.forkNs);
+  }
+  size_t inlineSize = 0, forkSize = 0;
+  void *inlineFile =
+      autosave_read_file(&memory.frame[0], SAVE_BENCH_PATH, &inlineSize);
+  void *forkFile =
+      autosave_read_file(&memory.frame[0], AUTOSAVE_BENCH_FORK_PATH, &forkSize);
+  if (autosaver.forkFailures || !inlineFile || !forkFile ||
+      inlineSize != forkSize || memcmp(inlineFile, forkFile, forkSize) != 0) {
+    fprintf(stderr, "autosave bench: the forked save differs\n");
+    exit(1);
+  }
+  unlink(SAVE_BENCH_PATH);
+  unlink(AUTOSAVE_BENCH_FORK_PATH);
+  UnloadAutosaver(&autosaver);
+
+  Vector2 playerPos = world->player->pos;
+  if (!LoadAutosave(&memory, AUTOSAVE_BENCH_DIR) ||
+      world->inventory[arch_item_wood] != 7 ||
+      !Vector2Equals(world->player->pos, playerPos)) {
+    fprintf(stderr, "autosave bench: couldn't load it back\n");
+    exit(1);
+  }
+  for (int c = 0; c < modified; c++) {
+    ChunkInfo *info = chunk_table_get(&world->chunks, coords[c]);
+    if (!info || !info->modified ||
+        WorldGenChunkDigest(world, coords[c]) != digests[c]) {
+      fprintf(stderr, "autosave bench: chunk %d,%d didn't come back\n",
+              coords[c].x, coords[c].y);
+      exit(1);
+    }
+    char path[256];
+    snprintf(path, sizeof(path), "%s/chunk_%d_%d.dat", AUTOSAVE_BENCH_DIR,
+             coords[c].x, coords[c].y);
+    unlink(path);
+  }
+  unlink(AUTOSAVE_BENCH_DIR "/world.dat");
+  rmdir(AUTOSAVE_BENCH_DIR);
+  ReleaseGameMemory(&memory);
+  world = NULL;
+
+  printf("  \"autosave\": {\n");
+  printf("    \"chunks_written\": %d,\n", modified);
+  printf("    \"kb_written\": %.1f,\n", bytes / 1024.0);
+  printf("    \"stage_ms\": %.3f,\n", stageNs / 1e6);
+  printf("    \"stage_ns_per_entity\": %.2f,\n",
+         (double)stageNs / SAVE_BENCH_ENTITIES);
+  printf("    \"write_ms\": %.2f,\n", writeNs / 1e6);
+  printf("    \"full_save_ms\": %.2f,\n", fullMs);
+  printf("    \"fork_pause_ms\": %.3f,\n", forkPauseNs / 1e6);
+  printf("    \"fork_save_ms\": %.2f\n", forkNs / 1e6);
+  printf("  },\n");
+}
+
+// Block compression on what saves hold - a generated World's entities as
+// the autosave writes them, and a whole save file, which is mostly the empty
+// end of the entity array. Every round trip must be exact and a damaged
+// block must be refused.
+#define COMPRESS_BENCH_BYTES MB(64) // processed per corpus and direction
+
+typedef struct CompressResult {
+  double ratio;
+  double compressGbPerS;
+  double decompressGbPerS;
+} CompressResult;
+
+CompressResult CompressCorpus(Arena *arena, const char *name,
+                              unsigned char *raw, size_t size) {
+  size_t capacity = lz_compress_bound(size);
+  unsigned char *packed = arena_alloc_nozero(arena, capacity);
+  unsigned char *unpacked = arena_alloc_nozero(arena, size);
+  if (!packed || !unpacked) {
+    fprintf(stderr, "compress bench: out of memory\n");
+    exit(1);
+  }
+  int reps = (int)(COMPRESS_BENCH_BYTES / size) + 1;
+
+  // The fastest pass in each direction - a pass is a few hundred us, so
+  // the total over all of them swings with whatever else the machine runs
+  size_t packedSize = 0;
+  uint64_t compressNs = UINT64_MAX;
+  for (int i = 0; i < reps; i++) {
+    uint64_t start = bench_now_ns();
+    packedSize = lz_compress(raw, size, packed, capacity);
+    compressNs = bench_min_ns(compressNs, bench_now_ns() - start);
+  }
+
+  bool ok = true;
+  uint64_t decompressNs = UINT64_MAX;
+  for (int i = 0; i < reps; i++) {
+    uint64_t start = bench_now_ns();
+    ok = lz_decompress(packed, packedSize, unpacked, size) && ok;
+    decompressNs = bench_min_ns(decompressNs, bench_now_ns() - start);
+  }
+  if (!ok || packedSize == 0 || memcmp(raw, unpacked, size) != 0) {
+    fprintf(stderr, "compress bench: %s doesn't round trip\n", name);
+    exit(1);
+  }
+  if (lz_decompress(packed, packedSize - 1, unpacked, size) ||
+      lz_decompress(packed, packedSize, unpacked, size - 1)) {
+    fprintf(stderr, "compress bench: %s cut short still decompressed\n",
+            name);
+    exit(1);
+  }
+  // Damaged anywhere, a block mustn't decompress out of bounds - whether
+  // it's caught depends on where the damage is
+  for (size_t i = 0; i < packedSize; i += packedSize / 64 + 1) {
+    packed[i] ^= 0x5a;
+    lz_decompress(packed, packedSize, unpacked, size);
+    packed[i] ^= 0x5a;
+  }
+
+  return (CompressResult){(double)size / packedSize,
+                          (double)size / (compressNs ? compressNs : 1),
+                          (double)size / (decompressNs ? decompressNs : 1)};
+}
+
+void PrintCompressResult(const char *name, CompressResult r, bool last) {
+  printf("    \"%s_ratio\": %.2f,\n", name, r.ratio);
+  printf("    \"%s_compress_gb_per_s\": %.2f,\n", name, r.compressGbPerS);
+  printf("    \"%s_decompress_gb_per_s\": %.2f%s\n", name,
+         r.decompressGbPerS, last ? "" : ",");
+}
+
+void PrintCompressBench(Arena *arena) {
+  arena_free_all(arena);
+  GameMemory memory;
+  if (!InitGameMemory(&memory) || !StartSession(&memory, BENCH_WORLD_SEED)) {
+    fprintf(stderr, "compress bench: out of memory\n");
+    exit(1);
+  }
+  ChunkCoord origin = {4, -4};
+  for (int y = 0; y < WORLDGEN_SIDE; y++) {
+    for (int x = 0; x < WORLDGEN_SIDE; x++) {
+      GenerateChunk(world, (ChunkCoord){origin.x + x, origin.y + y});
+    }
+  }
+
+  size_t chunkBytes = (world->entityHighWater - 1) * sizeof(SavedEntity);
+  SavedEntity *entities = arena_alloc_nozero(arena, chunkBytes);
+  for (int i = 1; i < world->entityHighWater; i++) {
+    entities[i - 1] = save_entity(world, &world->entities[i]);
+  }
+  CompressResult chunks =
+      CompressCorpus(arena, "chunks", (unsigned char *)entities, chunkBytes);
+
+  if (!SaveGame(world, &memory.frame[0], SAVE_BENCH_PATH)) {
+    fprintf(stderr, "compress bench: couldn't write %s\n", SAVE_BENCH_PATH);
+    exit(1);
+  }
+  size_t saveBytes = 0;
+  unsigned char *save = autosave_read_file(arena, SAVE_BENCH_PATH, &saveBytes);
+  unlink(SAVE_BENCH_PATH);
+  if (!save) {
+    fprintf(stderr, "compress bench: couldn't read %s\n", SAVE_BENCH_PATH);
+    exit(1);
+  }
+  CompressResult file = CompressCorpus(arena, "save", save, saveBytes);
+  ReleaseGameMemory(&memory);
+  world = NULL;
+
+  printf("  \"compress\": {\n");
+  printf("    \"chunks_kb\": %.1f,\n", chunkBytes / 1024.0);
+  PrintCompressResult("chunks", chunks, false);
+  printf("    \"save_kb\": %.1f,\n", saveBytes / 1024.0);
+  PrintCompressResult("save", file, true);
+  printf("  },\n");
+}
+
+// Rewind - every tick of a walk through a generated World is captured, and
+// restoring a captured frame has to give back exactly what was packed
+#define REWIND_BENCH_TICKS 900 // past REWIND_MAX_FRAMES, so frames are evicted
+#define REWIND_BENCH_CHECKS 3
+#define REWIND_BENCH_FULL_ENTITIES 65536 // the game's MAX_ENTITY_COUNT
+#define REWIND_BENCH_FULL_FRAMES 10
+
+// Whether the World packs to exactly reference. The chunks are compared as
+// a set - the table they're put back in may order them differently.
+bool RewindPackMatches(World *world, unsigned char *packed,
+                       unsigned char *reference, size_t referenceSize) {
+  size_t size = rewind_pack(world, packed);
+  RewindHeader header;
+  memcpy(&header, reference, sizeof(header));
+  size_t chunksAt = referenceSize - header.chunkCount * sizeof(RewindChunk);
+  if (size != referenceSize || memcmp(packed, reference, chunksAt) != 0) {
+    return false;
+  }
+  for (uint32_t i = 0; i < header.chunkCount; i++) {
+    RewindChunk *chunk = (RewindChunk *)(reference + chunksAt) + i;
+    ChunkInfo *info = chunk_table_get(&world->chunks, chunk->coord);
+    if (!info || info->state != chunk->state ||
+        info->modified != chunk->modified || info->unsaved != chunk->unsaved) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void PrintRewindBench(Arena *arena) {
+  arena_free_all(arena);
+  GameMemory memory;
+  static Rewind history;
+  if (!InitGameMemory(&memory) || !StartSession(&memory, BENCH_WORLD_SEED) ||
+      !InitRewind(&history, arena)) {
+    fprintf(stderr, "rewind bench: out of memory\n");
+    exit(1);
+  }
+  ChunkCoord origin = {-4, -4};
+  for (int y = 0; y < WORLDGEN_SIDE; y++) {
+    for (int x = 0; x < WORLDGEN_SIDE; x++) {
+      ChunkCoord coord = {origin.x + x, origin.y + y};
+      GenerateChunk(world, coord);
+      chunk_table_put(&world->chunks, coord)->state = chunk_loaded;
+    }
+  }
+
+  // Off until asked for
+  CaptureRewind(&history, world);
+  if (history.next != 0) {
+    fprintf(stderr, "rewind bench: captured without recording\n");
+    exit(1);
+  }
+  SetRewindRecording(&history, true);
+
+  // Frames checked after the walk, all still in the ring by then
+  const int checkTicks[REWIND_BENCH_CHECKS] = {
+      REWIND_BENCH_TICKS - REWIND_MAX_FRAMES + 7, REWIND_BENCH_TICKS - 200,
+      REWIND_BENCH_TICKS - 1};
+  unsigned char *references[REWIND_BENCH_CHECKS];
+  size_t referenceSizes[REWIND_BENCH_CHECKS];
+  uint64_t referenceSeqs[REWIND_BENCH_CHECKS];
+  int checks = 0;
+
+  const float deltaT = 1 / 60.0f;
+  uint64_t captureNs = 0;
+  size_t entityFrames = 0;
+  for (int tick = 0; tick < REWIND_BENCH_TICKS; tick++) {
+    float angle = tick * 0.01f;
+    UpdatePlayerMovement(world, v2(cosf(angle), sinf(angle)), deltaT);
+    UpdateClock(world, deltaT);
+    if (tick % 30 == 0) {
+      Vector2 tile = round_v2_to_tile(world->player->pos);
+      UpdateHarvest(world, (Rectangle){tile.x, tile.y, tileWidth, tileWidth});
+    }
+    UpdatePickup(world);
+    UpdateAnimation(world, tick * deltaT);
+    UpdateSpriteAnimation(world, deltaT);
+
+    uint64_t seq = history.next;
+    CaptureRewind(&history, world);
+    captureNs += history.captureNs;
+    entityFrames += world->entityHighWater;
+    if (history.next != seq + 1) {
+      fprintf(stderr, "rewind bench: tick %d wasn't captured\n", tick);
+      exit(1);
+    }
+    if (checks < REWIND_BENCH_CHECKS && tick == checkTicks[checks]) {
+      references[checks] = arena_alloc_nozero(arena, history.rawCapacity);
+      referenceSizes[checks] = rewind_pack(world, references[checks]);
+      referenceSeqs[checks] = seq;
+      checks++;
+    }
+  }
+
+  uint64_t kept = history.next - history.oldest;
+  double bytesPerFrame = (double)history.bytesUsed / kept;
+  double ratio = (double)history.rawBytes / history.bytesUsed;
+  int entities = world->entityHighWater;
+
+  // Oldest first, so each restore goes back in time from the last
+  uint64_t restoreNs = 0;
+  for (int c = 0; c < REWIND_BENCH_CHECKS; c++) {
+    uint64_t start = bench_now_ns();
+    bool restored = RestoreRewind(&history, world, referenceSeqs[c]);
+    restoreNs += bench_now_ns() - start;
+    if (!restored || !RewindPackMatches(world, history.packed, references[c],
+                                        referenceSizes[c])) {
+      fprintf(stderr, "rewind bench: frame %llu didn't restore\n",
+              (unsigned long long)referenceSeqs[c]);
+      exit(1);
+    }
+  }
+
+  // Scrubbing back then carrying on drops the frames after the cursor
+  if (!BeginRewind(&history, world)) {
+    fprintf(stderr, "rewind bench: nothing to scrub\n");
+    exit(1);
+  }
+  ScrubRewind(&history, world, -100);
+  EndRewind(&history);
+  size_t resumedSize = rewind_pack(world, references[0]);
+  CaptureRewind(&history, world);
+  if (history.next - history.oldest != kept - 99 ||
+      !RestoreRewind(&history, world, history.next - 1) ||
+      !RewindPackMatches(world, history.packed, references[0], resumedSize)) {
+    fprintf(stderr, "rewind bench: carrying on after a scrub went wrong\n");
+    exit(1);
+  }
+
+  // What a frame costs in the game with its entity array full - the
+  // fastest of a few, a keyframe and deltas against it with the items bobbing
+  for (int n = 0; world->entityHighWater < REWIND_BENCH_FULL_ENTITIES &&
+                  n < REWIND_BENCH_FULL_ENTITIES;
+       n++) {
+    SetupRock(GridTile(n, 300));
+  }
+  ResetRewind(&history);
+  uint64_t fullNs = UINT64_MAX;
+  for (int frame = 0; frame < REWIND_BENCH_FULL_FRAMES; frame++) {
+    UpdateAnimation(world, frame * deltaT);
+    uint64_t seq = history.next;
+    CaptureRewind(&history, world);
+    if (history.next != seq + 1) {
+      fprintf(stderr, "rewind bench: full frame %d wasn't captured\n", frame);
+      exit(1);
+    }
+    fullNs = bench_min_ns(fullNs, history.captureNs);
+  }
+  int fullEntities = world->entityHighWater;
+  ReleaseGameMemory(&memory);
+  world = NULL;
+
+  printf("  \"rewind\": {\n");
+  printf("    \"entities\": %d,\n", entities);
+  printf("    \"frames_kept\": %llu,\n", (unsigned long long)kept);
+  printf("    \"kb_per_frame\": %.2f,\n", bytesPerFrame / 1024.0);
+  printf("    \"ratio\": %.1f,\n", ratio);
+  printf("    \"capture_ns_per_entity\": %.2f,\n",
+         (double)captureNs / entityFrames);
+  printf("    \"restore_ms\": %.3f,\n",
+         restoreNs / 1e6 / REWIND_BENCH_CHECKS);
+  printf("    \"full_entities\": %d,\n", fullEntities);
+  printf("    \"full_capture_ms\": %.2f\n", fullNs / 1e6);
+  printf("  },\n");
+}
+
+int main(int argc, char **argv) {
+  int ticks = BENCH_DEFAULT_TICKS;
+  char *only = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+      ticks = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+      only = argv[++i];
+    } else {
+      fprintf(stderr, "usage: %s [--ticks N] [--scene NAME]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (ticks <= 0) {
+    ticks = BENCH_DEFAULT_TICKS;
+  }
+
+  Arena arena = {0};
+  if (!arena_init_reserve(&arena, BENCH_ARENA_RESERVE_SIZE)) {
+    fprintf(stderr, "could not reserve the bench arena\n");
+    return 1;
+  }
+  arena.name = "bench";
+
+  for (int i = 0; i < SPRITE_MAX; i++) {
+    sprites[i] = LoadSpriteSize(spritePaths[i]);
+  }
+
+  printf("{\n");
+  printf("  \"ticks\": %d,\n", ticks);
+  printf("  \"max_entity_count\": %d,\n", MAX_ENTITY_COUNT);
+  if (!only || strcmp(only, "arena") == 0) {
+    PrintArenaBench(&arena);
+  }
+  if (!only || strcmp(only, "pool") == 0) {
+    PrintPoolBench(&arena);
+  }
+  if (!only || strcmp(only, "threads") == 0) {
+    PrintThreadsBench(&arena);
+  }
+  if (!only || strcmp(only, "containers") == 0) {
+    PrintContainersBench(&arena);
+  }
+  if (!only || strcmp(only, "strings") == 0) {
+    PrintStringsBench(&arena);
+  }
+  if (!only || strcmp(only, "animation") == 0) {
+    PrintAnimationBench(&arena);
+  }
+  if (!only || strcmp(only, "noise") == 0) {
+    PrintNoiseBench(&arena);
+  }
+  if (!only || strcmp(only, "ground") == 0) {
+    PrintGroundBench(&arena);
+  }
+  if (!only || strcmp(only, "worldgen") == 0) {
+    PrintWorldGenBench(&arena);
+  }
+  if (!only || strcmp(only, "streaming") == 0) {
+    PrintStreamingBench(&arena);
+  }
+  if (!only || strcmp(only, "save") == 0) {
+    PrintSaveBench(&arena);
+  }
+  if (!only || strcmp(only, "autosave") == 0) {
+    PrintAutosaveBench(&arena);
+  }
+  if (!only || strcmp(only, "compress") == 0) {
+    PrintCompressBench(&arena);
+  }
+  if (!only || strcmp(only, "rewind") == 0) {
+    PrintRewindBench(&arena);
+  }
+  printf("  \"scenes\": {");
+  bool first = true;
+  for (int s = 0; s < SCENE_COUNT; s++) {
+    Scene *scene = &scenes[s];
+    if (only && strcmp(only, scene->name) != 0) {
+      continue;
+    }
+    SceneResult result = RunScene(&arena, scene, ticks);
+    double entityTicks = (double)result.entities * ticks;
+
+    printf("%s\n    \"%s\": {\n", first ? "" : ",", scene->name);
+    printf("      \"entities\": %d,\n", result.entities);
+    printf("      \"arena_high_water_kb\": %zu,\n",
+           result.arenaHighWater / 1024);
+    printf("      \"ticks_per_sec\": %.1f,\n",
+           ticks / (result.totalNs / 1e9));
+    printf("      \"ns_per_entity\": {");
+    for (int sys = 0; sys < SYSTEM_MAX; sys++) {
+      if (sys == system_harvest && !scene->harvestEvery) {
+        continue; // never clicks, there's nothing to time
+      }
+      printf("\"%s\": %.3f, ", systemNames[sys],
+             result.systemNs[sys] / entityTicks);
+    }
+    printf("\"total\": %.3f}\n", result.totalNs / entityTicks);
+    printf("    }");
+    first = false;
+  }
+  printf("\n  }\n}\n");
+
+  arena_print_report(&arena, stderr);
+  arena_release(&arena);
+  return 0;
+}
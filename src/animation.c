@@ -0,0 +1,65 @@
+//
+// Shared animation curves
+//
+// Every item bobs on the same sine curve, so the curve's sin and cos are
+// evaluated once per frame and each entity's phase is applied with the
+// angle-sum identity sin(wt + p) = sin(wt)cos(p) + cos(wt)sin(p). What's
+// left per entity is a couple of multiply-adds over the World's bob arrays,
+// done a vector at a time with GCC vector extensions (SSE/AVX on x86, NEON
+// on arm64). Entities that don't bob have an amplitude of 0.
+//
+
+#define ANIM_LANES 8
+// aligned(4) - the arrays are only float aligned, so loads are unaligned
+typedef float AnimLanes
+    __attribute__((vector_size(ANIM_LANES * sizeof(float)), aligned(4)));
+
+void UpdateAnimation(World *world, double time) {
+  float waveSin = (float)sin(time * itemBobRate);
+  float waveCos = (float)cos(time * itemBobRate);
+  int count = (world->entityHighWater + ANIM_LANES - 1) / ANIM_LANES *
+              ANIM_LANES;
+
+  for (int i = 0; i < count; i += ANIM_LANES) {
+    AnimLanes amplitude, phaseCos, phaseSin;
+    memcpy(&amplitude, &world->bobAmplitude[i], sizeof(AnimLanes));
+    memcpy(&phaseCos, &world->bobPhaseCos[i], sizeof(AnimLanes));
+    memcpy(&phaseSin, &world->bobPhaseSin[i], sizeof(AnimLanes));
+    AnimLanes wave = waveSin * phaseCos + waveCos * phaseSin;
+    // the wave moved into 0..1
+    AnimLanes offset = amplitude * (wave * 0.5f + 0.5f);
+    memcpy(&world->bobOffset[i], &offset, sizeof(AnimLanes));
+  }
+}
+
+// Evaluates the curve per entity like the draw loop used to - kept as the
+// reference UpdateAnimation is checked against
+void UpdateAnimationScalar(World *world, double time) {
+  for (int i = 0; i < world->entityHighWater; i++) {
+    double wave = sin(time * itemBobRate) * world->bobPhaseCos[i] +
+                  cos(time * itemBobRate) * world->bobPhaseSin[i];
+    world->bobOffset[i] = world->bobAmplitude[i] * (wave + 1.0) / 2.0;
+  }
+}
+
+//
+// Sprite sheet playback
+//
+// Picks every animated entity's frame once per tick from the shared clock,
+// so drawing only has to read animFrame. Entities with clip_none are
+// skipped and draw their sprite_id.
+//
+
+void UpdateSpriteAnimation(World *world, float deltaT) {
+  world->animClock += deltaT;
+  float clock = world->animClock;
+  for (int i = 0; i < world->entityHighWater; i++) {
+    uint8_t clipId = world->animClip[i];
+    if (clipId == clip_none) {
+      continue;
+    }
+    AnimClip clip = animClips[clipId];
+    unsigned step = (unsigned)((clock - world->animStart[i]) * clip.fps);
+    world->animFrame[i] = clip.firstFrame + step % clip.frameCount;
+  }
+}
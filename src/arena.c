@@ -0,0 +1,482 @@
+//
+// Arena allocator - shared by the game and the headless tools
+//
+
+#define assert(cond, ...)                                                      \
+  { assert_line(__LINE__, cond, __VA_ARGS__) }
+#if CONFIGURATION == RELEASE
+#undef assert
+#define assert(x, ...) (void)(x)
+#endif
+
+// Memory Sizes
+#define KB(x) (x * 1024ull)
+#define MB(x) ((KB(x)) * 1024ull)
+#define GB(x) ((MB(x)) * 1024ull)
+
+//
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if !defined(__cplusplus)
+#if (defined(_MSC_VER) && _MSC_VER < 1800) ||                                  \
+    (!defined(_MSC_VER) && !defined(__STDC_VERSION__))
+#ifndef true
+#define true (0 == 0)
+#endif
+#ifndef false
+#define false (0 != 0)
+#endif
+typedef unsigned char bool;
+#else
+#include <stdbool.h>
+#endif
+#endif
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+bool is_power_of_two(uintptr_t x) { return (x & (x - 1)) == 0; }
+
+uintptr_t align_forward(uintptr_t ptr, size_t align) {
+  uintptr_t p, a, modulo;
+
+  assert(is_power_of_two(align));
+
+  p = ptr;
+  a = (uintptr_t)align;
+  // Same as (p % a) but faster as 'a' is a power of two
+  modulo = p & (a - 1);
+
+  if (modulo != 0) {
+    // If 'p' address is not aligned, push the address to the
+    // next value which is aligned
+    p += a - modulo;
+  }
+  return p;
+}
+
+#ifndef DEFAULT_ALIGNMENT
+#define DEFAULT_ALIGNMENT (2 * sizeof(void *))
+#endif
+
+// A multiple of every target's page size (16 KB on Apple silicon, 4 KB on
+// x86) for rounding ranges to whole pages
+#ifndef ARENA_PAGE_SIZE
+#define ARENA_PAGE_SIZE KB(16)
+#endif
+
+// Reserved arenas commit in steps of this (a multiple of the page size) so
+// bumping through small allocations isn't a syscall each
+#ifndef ARENA_COMMIT_GRANULARITY
+#define ARENA_COMMIT_GRANULARITY KB(64)
+#endif
+
+// Committed pages a reserved arena keeps through arena_free_all, so the
+// per-frame resets stay free. Anything above goes back to the OS.
+#ifndef ARENA_RETAIN_COMMITTED
+#define ARENA_RETAIN_COMMITTED MB(1)
+#endif
+
+// Optional tags so usage can be broken down by what it was for. Untagged
+// allocations are counted under arena_tag_untagged.
+typedef enum ArenaTag {
+  arena_tag_untagged = 0,
+  arena_tag_world,
+  arena_tag_hud,
+  arena_tag_pool,
+  arena_tag_threads,
+  ARENA_TAG_MAX
+} ArenaTag;
+char *arenaTagNames[ARENA_TAG_MAX] = {
+    [arena_tag_untagged] = "untagged",
+    [arena_tag_world] = "world",
+    [arena_tag_hud] = "hud",
+    [arena_tag_pool] = "pool",
+    [arena_tag_threads] = "threads",
+};
+
+typedef enum ArenaFlags {
+  arena_flags_none = 0,
+  // Skip the memset - for buffers the caller overwrites straight away
+  arena_flag_no_zero = 1 << 0,
+} ArenaFlags;
+
+typedef struct ArenaStats {
+  size_t high_water; // largest curr_offset ever reached
+  // Totals since init - temp memory and arena_free_all don't subtract
+  size_t tag_bytes[ARENA_TAG_MAX];
+  size_t tag_allocs[ARENA_TAG_MAX];
+  size_t overflow_count;
+  size_t largest_overflow; // biggest request that didn't fit
+} ArenaStats;
+
+typedef struct Arena Arena;
+struct Arena {
+  unsigned char *buf;
+  size_t buf_len;
+  size_t prev_offset; // This will be useful for later on
+  size_t curr_offset;
+  char *name;          // for reports, may be NULL
+  ArenaTag prev_tag;   // tag of the allocation at prev_offset
+  ArenaStats stats;
+  // Reserved (virtual memory) arenas only - buf_len is the reserved range
+  // and only [0, committed) is readable/writable
+  bool is_reserved;
+  size_t committed;
+  // Nothing at or past this offset has been handed out since it was
+  // committed, so it is still the zero page the kernel gave us
+  size_t clean_offset;
+};
+
+void arena_init(Arena *a, void *backing_buffer, size_t backing_buffer_length) {
+  a->buf = (unsigned char *)backing_buffer;
+  a->buf_len = backing_buffer_length;
+  a->curr_offset = 0;
+  a->prev_offset = 0;
+  a->prev_tag = arena_tag_untagged;
+  a->is_reserved = false;
+  a->committed = backing_buffer_length;
+  a->clean_offset = backing_buffer_length; // malloc'd memory is never clean
+  memset(&a->stats, 0, sizeof(a->stats));
+}
+
+// Reserves address space without backing it - pages are committed as
+// curr_offset moves past them, so pointers never move and resident memory
+// tracks what is actually used. Returns false if the reservation failed.
+bool arena_init_reserve(Arena *a, size_t reserve_size) {
+  void *base = mmap(NULL, reserve_size, PROT_NONE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (base == MAP_FAILED) {
+    memset(a, 0, sizeof(*a));
+    return false;
+  }
+  arena_init(a, base, reserve_size);
+  a->is_reserved = true;
+  a->committed = 0;
+  a->clean_offset = 0;
+  return true;
+}
+
+// Unmaps a reserved arena. Fixed arenas are owned by whoever passed in the
+// backing buffer.
+void arena_release(Arena *a) {
+  if (a->is_reserved) {
+    munmap(a->buf, a->buf_len);
+  }
+  memset(a, 0, sizeof(*a));
+}
+
+// Leaves the whole pages inside [base, base + size) out of any child this
+// process forks, for big buffers a child never reads - fork() then has
+// fewer page tables to copy. Does nothing where the OS can't.
+void exclude_from_fork(void *base, size_t size) {
+#ifdef MADV_DONTFORK
+  uintptr_t start = align_forward((uintptr_t)base, ARENA_PAGE_SIZE);
+  uintptr_t end = ((uintptr_t)base + size) & ~(uintptr_t)(ARENA_PAGE_SIZE - 1);
+  if (end > start) {
+    madvise((void *)start, end - start, MADV_DONTFORK);
+  }
+#endif
+}
+
+// Makes sure [0, end) is usable, committing more of a reserved arena
+bool arena_ensure_committed(Arena *a, size_t end) {
+  if (end > a->buf_len) {
+    return false;
+  }
+  if (end <= a->committed) {
+    return true;
+  }
+  size_t new_committed = align_forward(end, ARENA_COMMIT_GRANULARITY);
+  if (new_committed > a->buf_len) {
+    new_committed = a->buf_len;
+  }
+  if (mprotect(a->buf + a->committed, new_committed - a->committed,
+               PROT_READ | PROT_WRITE) != 0) {
+    return false;
+  }
+  a->committed = new_committed;
+  return true;
+}
+
+void arena_note_overflow(Arena *a, size_t size) {
+  // Only shout the first time - after that it's in the exit report
+  if (a->stats.overflow_count == 0) {
+    fprintf(stderr,
+            "arena '%s' out of memory: %zu byte request with %zu of %zu "
+            "bytes used\n",
+            a->name ? a->name : "?", size, a->curr_offset, a->buf_len);
+  }
+  a->stats.overflow_count += 1;
+  if (size > a->stats.largest_overflow) {
+    a->stats.largest_overflow = size;
+  }
+}
+
+void arena_note_alloc(Arena *a, size_t size, ArenaTag tag) {
+  a->stats.tag_bytes[tag] += size;
+  a->stats.tag_allocs[tag] += 1;
+  if (a->curr_offset > a->stats.high_water) {
+    a->stats.high_water = a->curr_offset;
+  }
+}
+
+// Zeroes [offset, offset + size) unless it's fresh from the kernel
+void arena_zero_range(Arena *a, size_t offset, size_t size, ArenaFlags flags) {
+  size_t end = offset + size;
+  if (!(flags & arena_flag_no_zero) && offset < a->clean_offset) {
+    size_t dirty_end = end < a->clean_offset ? end : a->clean_offset;
+    memset(&a->buf[offset], 0, dirty_end - offset);
+  }
+  if (end > a->clean_offset) {
+    a->clean_offset = end;
+  }
+}
+
+void *arena_alloc_align_flags(Arena *a, size_t size, size_t align,
+                              ArenaTag tag, ArenaFlags flags) {
+  // Align 'curr_offset' forward to the specified alignment
+  uintptr_t curr_ptr = (uintptr_t)a->buf + (uintptr_t)a->curr_offset;
+  uintptr_t offset = align_forward(curr_ptr, align);
+  offset -= (uintptr_t)a->buf; // Change to relative offset
+
+  // Check to see if the backing memory has space left
+  if (arena_ensure_committed(a, offset + size)) {
+    void *ptr = &a->buf[offset];
+    a->prev_offset = offset;
+    a->curr_offset = offset + size;
+    a->prev_tag = tag;
+    arena_note_alloc(a, size, tag);
+
+    // Zero new memory by default
+    arena_zero_range(a, offset, size, flags);
+    return ptr;
+  }
+  // Return NULL if the arena is out of memory - callers must check
+  arena_note_overflow(a, size);
+  return NULL;
+}
+
+void *arena_alloc_align_tagged(Arena *a, size_t size, size_t align,
+                               ArenaTag tag) {
+  return arena_alloc_align_flags(a, size, align, tag, arena_flags_none);
+}
+
+void *arena_alloc_align(Arena *a, size_t size, size_t align) {
+  return arena_alloc_align_tagged(a, size, align, arena_tag_untagged);
+}
+
+// Because C doesn't have default parameters
+void *arena_alloc(Arena *a, size_t size) {
+  return arena_alloc_align(a, size, DEFAULT_ALIGNMENT);
+}
+
+void *arena_alloc_tagged(Arena *a, size_t size, ArenaTag tag) {
+  return arena_alloc_align_tagged(a, size, DEFAULT_ALIGNMENT, tag);
+}
+
+// Contents are garbage - only for memory that is fully written before use
+void *arena_alloc_nozero(Arena *a, size_t size) {
+  return arena_alloc_align_flags(a, size, DEFAULT_ALIGNMENT,
+                                 arena_tag_untagged, arena_flag_no_zero);
+}
+
+void *arena_alloc_nozero_tagged(Arena *a, size_t size, ArenaTag tag) {
+  return arena_alloc_align_flags(a, size, DEFAULT_ALIGNMENT, tag,
+                                 arena_flag_no_zero);
+}
+
+void arena_free(Arena *a, void *ptr) {
+  // Do nothing
+}
+
+// With arena_flag_no_zero the grown tail is left uninitialised
+void *arena_resize_align_flags(Arena *a, void *old_memory, size_t old_size,
+                               size_t new_size, size_t align,
+                               ArenaFlags flags) {
+  unsigned char *old_mem = (unsigned char *)old_memory;
+
+  assert(is_power_of_two(align));
+
+  if (old_mem == NULL || old_size == 0) {
+    return arena_alloc_align_flags(a, new_size, align, arena_tag_untagged,
+                                   flags);
+  } else if (a->buf <= old_mem && old_mem < a->buf + a->buf_len) {
+    if (a->buf + a->prev_offset == old_mem) {
+      if (!arena_ensure_committed(a, a->prev_offset + new_size)) {
+        arena_note_overflow(a, new_size);
+        return NULL;
+      }
+      a->curr_offset = a->prev_offset + new_size;
+      if (new_size > old_size) {
+        // Zero the new memory by default
+        arena_zero_range(a, a->prev_offset + old_size, new_size - old_size,
+                         flags);
+        arena_note_alloc(a, new_size - old_size, a->prev_tag);
+      }
+      return old_memory;
+    } else {
+      // The copy overwrites the front so only the tail needs zeroing
+      void *new_memory = arena_alloc_align_flags(a, new_size, align,
+                                                 a->prev_tag,
+                                                 arena_flag_no_zero);
+      if (new_memory == NULL) {
+        return NULL;
+      }
+      size_t copy_size = old_size < new_size ? old_size : new_size;
+      // Copy across old memory to the new memory
+      memmove(new_memory, old_memory, copy_size);
+      size_t new_offset = (unsigned char *)new_memory - a->buf;
+      if (!(flags & arena_flag_no_zero) && new_size > copy_size) {
+        memset(&a->buf[new_offset + copy_size], 0, new_size - copy_size);
+      }
+      return new_memory;
+    }
+
+  } else {
+    assert(0 && "Memory is out of bounds of the buffer in this arena");
+    return NULL;
+  }
+}
+
+void *arena_resize_align(Arena *a, void *old_memory, size_t old_size,
+                         size_t new_size, size_t align) {
+  return arena_resize_align_flags(a, old_memory, old_size, new_size, align,
+                                  arena_flags_none);
+}
+
+// Because C doesn't have default parameters
+void *arena_resize(Arena *a, void *old_memory, size_t old_size,
+                   size_t new_size) {
+  return arena_resize_align(a, old_memory, old_size, new_size,
+                            DEFAULT_ALIGNMENT);
+}
+
+void *arena_resize_nozero(Arena *a, void *old_memory, size_t old_size,
+                          size_t new_size) {
+  return arena_resize_align_flags(a, old_memory, old_size, new_size,
+                                  DEFAULT_ALIGNMENT, arena_flag_no_zero);
+}
+
+// Formats straight into the arena's free tail and then claims exactly the
+// bytes written (plus the terminator), so the common case is one vsnprintf
+// and no guessed buffer size. Only if the tail is too short is it formatted
+// a second time into a fresh allocation of the measured size.
+char *arena_vprintf_tagged(Arena *a, ArenaTag tag, const char *fmt,
+                           va_list args) {
+  va_list retry;
+  va_copy(retry, args);
+
+  size_t start = a->curr_offset;
+  size_t avail = a->committed > start ? a->committed - start : 0;
+  int length = vsnprintf(avail ? (char *)&a->buf[start] : NULL, avail, fmt,
+                         args);
+  if (length < 0) {
+    va_end(retry);
+    return NULL;
+  }
+  // Whatever vsnprintf touched is no longer known-zero
+  size_t touched = (size_t)length + 1 < avail ? (size_t)length + 1 : avail;
+  if (start + touched > a->clean_offset) {
+    a->clean_offset = start + touched;
+  }
+
+  char *str = arena_alloc_align_flags(a, length + 1, 1, tag,
+                                      arena_flag_no_zero);
+  if (str && (size_t)length >= avail) {
+    vsnprintf(str, length + 1, fmt, retry);
+  }
+  va_end(retry);
+  return str;
+}
+
+char *arena_printf_tagged(Arena *a, ArenaTag tag, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+char *arena_printf_tagged(Arena *a, ArenaTag tag, const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  char *str = arena_vprintf_tagged(a, tag, fmt, args);
+  va_end(args);
+  return str;
+}
+
+char *arena_printf(Arena *a, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+char *arena_printf(Arena *a, const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  char *str = arena_vprintf_tagged(a, arena_tag_untagged, fmt, args);
+  va_end(args);
+  return str;
+}
+
+// Gives a reserved arena's committed pages past keep back to the OS. Mapping
+// fresh PROT_NONE pages over them drops the memory and leaves the range as
+// it was reserved, zero the next time it's committed.
+void arena_decommit_above(Arena *a, size_t keep) {
+  keep = align_forward(keep, ARENA_COMMIT_GRANULARITY);
+  if (!a->is_reserved || keep < a->curr_offset || keep >= a->committed) {
+    return;
+  }
+  if (mmap(a->buf + keep, a->committed - keep, PROT_NONE,
+           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1,
+           0) == MAP_FAILED) {
+    return; // still committed, which is only a waste
+  }
+  a->committed = keep;
+  if (a->clean_offset > keep) {
+    a->clean_offset = keep;
+  }
+}
+
+void arena_free_all(Arena *a) {
+  a->curr_offset = 0;
+  a->prev_offset = 0;
+  arena_decommit_above(a, ARENA_RETAIN_COMMITTED);
+}
+
+// Extra Features
+typedef struct Temp_Arena_Memory Temp_Arena_Memory;
+struct Temp_Arena_Memory {
+  Arena *arena;
+  size_t prev_offset;
+  size_t curr_offset;
+};
+
+Temp_Arena_Memory temp_arena_memory_begin(Arena *a) {
+  Temp_Arena_Memory temp;
+  temp.arena = a;
+  temp.prev_offset = a->prev_offset;
+  temp.curr_offset = a->curr_offset;
+  return temp;
+}
+
+void temp_arena_memory_end(Temp_Arena_Memory temp) {
+  temp.arena->prev_offset = temp.prev_offset;
+  temp.arena->curr_offset = temp.curr_offset;
+}
+
+// Printed at exit so arenas can be sized from real usage
+void arena_print_report(Arena *a, FILE *out) {
+  fprintf(out, "arena '%s': high water %zu of %zu bytes (%.1f%%)\n",
+          a->name ? a->name : "?", a->stats.high_water, a->buf_len,
+          a->buf_len ? 100.0 * a->stats.high_water / a->buf_len : 0.0);
+  if (a->is_reserved) {
+    fprintf(out, "  committed  %10zu bytes\n", a->committed);
+  }
+  for (int i = 0; i < ARENA_TAG_MAX; i++) {
+    if (a->stats.tag_allocs[i]) {
+      fprintf(out, "  %-10s %10zu bytes %8zu allocs\n", arenaTagNames[i],
+              a->stats.tag_bytes[i], a->stats.tag_allocs[i]);
+    }
+  }
+  if (a->stats.overflow_count) {
+    fprintf(out, "  OVERFLOWED %zu times, largest request %zu bytes\n",
+            a->stats.overflow_count, a->stats.largest_overflow);
+  }
+}
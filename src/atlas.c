@@ -0,0 +1,308 @@
+//
+// Texture atlas - sprites, text and shapes in one texture
+//
+// At startup every sprite, every generated animation frame and every glyph
+// of the default font, rasterized with nearest-neighbour at each size the
+// game draws text at, is packed into a single texture. A white texel is
+// packed too and handed to raylib as the shapes texture. Sprites, text and
+// rectangles then all draw as quads from the same texture, so raylib's
+// batch never has to flush for a texture switch between them.
+//
+
+#define ATLAS_SIZE 1024
+#define ATLAS_PADDING 1
+#define ATLAS_FIRST_GLYPH 32 // printable ASCII only
+#define ATLAS_GLYPH_COUNT 95
+#define ATLAS_FONT_COUNT 3
+#define ATLAS_MEASURE_CACHE_MAX 1024
+
+// The sizes DrawText is called with - the overlay, menus and the HUD
+const int atlasFontSizes[ATLAS_FONT_COUNT] = {20, 24, 40};
+
+typedef struct AtlasGlyph {
+  Rectangle src;
+  float advance; // not including the spacing between glyphs
+} AtlasGlyph;
+
+typedef struct AtlasFont {
+  int size;
+  float spacing; // matches DrawText - one base pixel at this size
+  AtlasGlyph glyphs[ATLAS_GLYPH_COUNT];
+} AtlasFont;
+
+// Text widths keyed on a hash of the string and font size
+HASHMAP_DEFINE(uint64_t, int, TextWidthCache, text_width_cache, hash_u64,
+               eq_u64)
+
+typedef struct Atlas {
+  Texture2D texture;
+  Rectangle sprites[SPRITE_MAX];
+  Rectangle frames[FRAME_MAX]; // the sprites, then the generated animFrames
+  Rectangle ground; // GROUND_TILE_MAX tiles side by side
+  Rectangle white;
+  AtlasFont fonts[ATLAS_FONT_COUNT];
+  TextWidthCache widths;
+} Atlas;
+
+// Shelf packer - fills rows left to right, a new row starts below the
+// tallest item of the current one
+typedef struct AtlasPacker {
+  Image image;
+  int x;
+  int y;
+  int rowHeight;
+} AtlasPacker;
+
+bool atlas_pack(AtlasPacker *packer, Image image, Rectangle *out) {
+  if (packer->x + image.width > packer->image.width) {
+    packer->x = 0;
+    packer->y += packer->rowHeight + ATLAS_PADDING;
+    packer->rowHeight = 0;
+  }
+  if (image.width > packer->image.width ||
+      packer->y + image.height > packer->image.height) {
+    return false;
+  }
+
+  *out = (Rectangle){packer->x, packer->y, image.width, image.height};
+  ImageDraw(&packer->image, image, (Rectangle){0, 0, image.width, image.height},
+            *out, WHITE);
+  packer->x += image.width + ATLAS_PADDING;
+  if (image.height > packer->rowHeight) {
+    packer->rowHeight = image.height;
+  }
+  return true;
+}
+
+bool atlas_pack_font(AtlasPacker *packer, AtlasFont *out, Font font,
+                     int size) {
+  float scale = (float)size / font.baseSize;
+  out->size = size;
+  out->spacing = (float)size / 10; // DrawText's spacing for the default font
+  for (int i = 0; i < ATLAS_GLYPH_COUNT; i++) {
+    int codepoint = ATLAS_FIRST_GLYPH + i;
+    int index = GetGlyphIndex(font, codepoint);
+    GlyphInfo info = font.glyphs[index];
+    Rectangle rec = font.recs[index];
+    AtlasGlyph *glyph = &out->glyphs[i];
+    glyph->advance = (info.advanceX ? info.advanceX : rec.width) * scale;
+
+    Image image = ImageCopy(info.image);
+    ImageResizeNN(&image, (int)(image.width * scale + 0.5f),
+                  (int)(image.height * scale + 0.5f));
+    bool packed = atlas_pack(packer, image, &glyph->src);
+    UnloadImage(image);
+    if (!packed) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Bakes an AnimFrame's shear and flip into a copy of its sprite
+Image atlas_frame_image(Image sprite, AnimFrame frame) {
+  Image image = GenImageColor(sprite.width, sprite.height, BLANK);
+  for (int y = 0; y < sprite.height; y++) {
+    int rows = sprite.height > 1 ? sprite.height - 1 : 1;
+    int shift = (int)roundf(frame.shear * (float)(rows - y) / rows);
+    for (int x = 0; x < sprite.width; x++) {
+      int from = x - shift;
+      if (from >= 0 && from < sprite.width) {
+        ImageDrawPixel(&image, x, y, GetImageColor(sprite, from, y));
+      }
+    }
+  }
+  if (frame.flipX) {
+    ImageFlipHorizontal(&image);
+  }
+  return image;
+}
+
+// Needs the window (for the default font and to upload the texture).
+// Fills in sprites[] with each sprite's size for the simulation.
+bool BuildAtlas(Atlas *atlas, Arena *arena) {
+  memset(atlas, 0, sizeof(*atlas));
+  AtlasPacker packer = {.image = GenImageColor(ATLAS_SIZE, ATLAS_SIZE, BLANK)};
+  bool ok = true;
+
+  Image images[SPRITE_MAX];
+  for (int i = 0; i < SPRITE_MAX; i++) {
+    images[i] = LoadImage(spritePaths[i]);
+    if (!images[i].data) {
+      // missing art shows up as the nil texture, like LoadTexture's default
+      images[i] = i != sprite_nil && images[sprite_nil].data
+                      ? ImageCopy(images[sprite_nil])
+                      : GenImageColor(1, 1, MAGENTA);
+    }
+    ok = ok && atlas_pack(&packer, images[i], &atlas->sprites[i]);
+    atlas->frames[i] = atlas->sprites[i];
+    sprites[i] =
+        (Texture2D){.width = images[i].width, .height = images[i].height};
+  }
+  for (size_t i = 0; ok && i < ANIM_FRAME_COUNT; i++) {
+    Image frame = atlas_frame_image(images[animFrames[i].sprite], animFrames[i]);
+    ok = atlas_pack(&packer, frame, &atlas->frames[SPRITE_MAX + i]);
+    UnloadImage(frame);
+  }
+  for (int i = 0; i < SPRITE_MAX; i++) {
+    UnloadImage(images[i]);
+  }
+
+  Image ground = GenImageColor(GROUND_TILE_MAX * GROUND_TILE_TEXELS,
+                               GROUND_TILE_TEXELS, BLANK);
+  for (int tile = 0; tile < GROUND_TILE_MAX; tile++) {
+    for (int y = 0; y < GROUND_TILE_TEXELS; y++) {
+      for (int x = 0; x < GROUND_TILE_TEXELS; x++) {
+        ImageDrawPixel(&ground, tile * GROUND_TILE_TEXELS + x, y,
+                       GroundTilesetTexel(tile, x, y));
+      }
+    }
+  }
+  ok = ok && atlas_pack(&packer, ground, &atlas->ground);
+  UnloadImage(ground);
+
+  // 3x3 so sampling the centre texel never bleeds into a neighbour
+  Image white = GenImageColor(3, 3, WHITE);
+  Rectangle whiteRec = {0};
+  ok = ok && atlas_pack(&packer, white, &whiteRec);
+  UnloadImage(white);
+  if (ok) {
+    // left zeroed if it never got packed - the atlas is refused below
+    atlas->white = (Rectangle){whiteRec.x + 1, whiteRec.y + 1, 1, 1};
+  }
+
+  Font font = GetFontDefault();
+  for (int i = 0; ok && i < ATLAS_FONT_COUNT; i++) {
+    ok = atlas_pack_font(&packer, &atlas->fonts[i], font, atlasFontSizes[i]);
+  }
+
+  if (ok) {
+    atlas->texture = LoadTextureFromImage(packer.image);
+    SetShapesTexture(atlas->texture, atlas->white);
+    ok = text_width_cache_init(&atlas->widths, arena, 256);
+  } else {
+    fprintf(stderr, "atlas: everything doesn't fit in %dx%d\n", ATLAS_SIZE,
+            ATLAS_SIZE);
+  }
+  UnloadImage(packer.image);
+  return ok;
+}
+
+void UnloadAtlas(Atlas *atlas) {
+  SetShapesTexture((Texture2D){0}, (Rectangle){0});
+  UnloadTexture(atlas->texture);
+}
+
+void DrawSprite(Atlas *atlas, SpriteId id, Vector2 pos, float scale,
+                Color tint) {
+  Rectangle src = atlas->sprites[id];
+  DrawTexturePro(atlas->texture, src,
+                 (Rectangle){pos.x, pos.y, src.width * scale,
+                             src.height * scale},
+                 v2(0, 0), 0.0f, tint);
+}
+
+void DrawFrame(Atlas *atlas, int frame, Vector2 pos, float scale,
+               Color tint) {
+  Rectangle src = atlas->frames[frame];
+  DrawTexturePro(atlas->texture, src,
+                 (Rectangle){pos.x, pos.y, src.width * scale,
+                             src.height * scale},
+                 v2(0, 0), 0.0f, tint);
+}
+
+// NULL if the size wasn't baked - callers fall back to raylib's DrawText
+AtlasFont *GetAtlasFont(Atlas *atlas, int size) {
+  for (int i = 0; i < ATLAS_FONT_COUNT; i++) {
+    if (atlas->fonts[i].size == size) {
+      return &atlas->fonts[i];
+    }
+  }
+  return NULL;
+}
+
+AtlasGlyph *atlas_glyph(AtlasFont *font, char c) {
+  int index = (unsigned char)c - ATLAS_FIRST_GLYPH;
+  if (index < 0 || index >= ATLAS_GLYPH_COUNT) {
+    index = '?' - ATLAS_FIRST_GLYPH;
+  }
+  return &font->glyphs[index];
+}
+
+// Same layout as DrawText - top left at x, y
+void DrawAtlasText(Atlas *atlas, const char *text, int x, int y, int size,
+                   Color color) {
+  AtlasFont *font = GetAtlasFont(atlas, size);
+  if (!font) {
+    DrawText(text, x, y, size, color);
+    return;
+  }
+  float penX = x;
+  float penY = y;
+  for (const char *c = text; *c; c++) {
+    if (*c == '\n') {
+      penX = x;
+      penY += size + 2; // raylib's default line spacing
+      continue;
+    }
+    AtlasGlyph *glyph = atlas_glyph(font, *c);
+    if (*c != ' ') {
+      DrawTexturePro(atlas->texture, glyph->src,
+                     (Rectangle){penX, penY, glyph->src.width,
+                                 glyph->src.height},
+                     v2(0, 0), 0.0f, color);
+    }
+    penX += glyph->advance + font->spacing;
+  }
+}
+
+uint64_t text_hash(const char *text, int size) {
+  // FNV-1a
+  uint64_t hash = 0xcbf29ce484222325ull ^ (uint64_t)size;
+  for (const char *c = text; *c; c++) {
+    hash ^= (unsigned char)*c;
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+// Width of the widest line. Cached, so it's meant for strings that repeat
+// from frame to frame like labels and menu text.
+int MeasureAtlasText(Atlas *atlas, const char *text, int size) {
+  AtlasFont *font = GetAtlasFont(atlas, size);
+  if (!font) {
+    return MeasureText(text, size);
+  }
+
+  uint64_t key = text_hash(text, size);
+  int *cached = text_width_cache_get(&atlas->widths, key);
+  if (cached) {
+    return *cached;
+  }
+
+  float width = 0;
+  float lineWidth = 0;
+  for (const char *c = text; *c; c++) {
+    if (*c == '\n') {
+      lineWidth = 0;
+      continue;
+    }
+    if (lineWidth > 0) {
+      lineWidth += font->spacing;
+    }
+    lineWidth += atlas_glyph(font, *c)->advance;
+    if (lineWidth > width) {
+      width = lineWidth;
+    }
+  }
+
+  // Strings that change every frame would otherwise grow it forever
+  if (atlas->widths.count >= ATLAS_MEASURE_CACHE_MAX) {
+    text_width_cache_clear(&atlas->widths);
+  }
+  int *slot = text_width_cache_put(&atlas->widths, key);
+  if (slot) {
+    *slot = (int)width;
+  }
+  return (int)width;
+}
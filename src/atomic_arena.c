@@ -0,0 +1,127 @@
+//
+// Thread-safe bump arena for worker threads
+//
+// AtomicArena is a block of memory carved out of a normal Arena up front.
+// Any thread may allocate from it - the offset is advanced with a single
+// atomic fetch-add, so there are no locks and no CAS retry loops. It can
+// only be reset when no thread is using it (eg. between job batches).
+//
+// ThreadArena is the common path: each worker owns one and bump allocates
+// from a private block it grabbed from the shared AtomicArena. Only when a
+// block runs out does it touch the shared offset again, so contention is
+// one atomic per block rather than one per allocation.
+//
+
+typedef struct AtomicArena {
+  unsigned char *buf;
+  size_t buf_len;
+  size_t curr_offset;    // only accessed with __atomic builtins
+  size_t overflow_count; // only accessed with __atomic builtins
+} AtomicArena;
+
+// Every reservation is a multiple of this so alignments up to it are free
+#define ATOMIC_ARENA_ALIGNMENT 64
+
+bool atomic_arena_init(AtomicArena *a, Arena *parent, size_t size) {
+  memset(a, 0, sizeof(*a));
+  size = align_forward(size, ATOMIC_ARENA_ALIGNMENT);
+  a->buf = arena_alloc_align_flags(parent, size, ATOMIC_ARENA_ALIGNMENT,
+                                   arena_tag_threads, arena_flag_no_zero);
+  if (!a->buf) {
+    return false;
+  }
+  a->buf_len = size;
+  return true;
+}
+
+void *atomic_arena_alloc_align_flags(AtomicArena *a, size_t size,
+                                     size_t align, ArenaFlags flags) {
+  assert(is_power_of_two(align));
+  size_t reserve = align_forward(size, ATOMIC_ARENA_ALIGNMENT);
+  if (align > ATOMIC_ARENA_ALIGNMENT) {
+    reserve += align - ATOMIC_ARENA_ALIGNMENT;
+  }
+
+  size_t offset =
+      __atomic_fetch_add(&a->curr_offset, reserve, __ATOMIC_RELAXED);
+  if (offset + reserve > a->buf_len) {
+    // Leave the offset past the end - every later request fails fast too
+    __atomic_fetch_add(&a->overflow_count, 1, __ATOMIC_RELAXED);
+    return NULL;
+  }
+
+  void *ptr = (void *)align_forward((uintptr_t)(a->buf + offset), align);
+  if (!(flags & arena_flag_no_zero)) {
+    memset(ptr, 0, size);
+  }
+  return ptr;
+}
+
+void *atomic_arena_alloc(AtomicArena *a, size_t size) {
+  return atomic_arena_alloc_align_flags(a, size, DEFAULT_ALIGNMENT,
+                                        arena_flags_none);
+}
+
+void *atomic_arena_alloc_nozero(AtomicArena *a, size_t size) {
+  return atomic_arena_alloc_align_flags(a, size, DEFAULT_ALIGNMENT,
+                                        arena_flag_no_zero);
+}
+
+// Bytes handed out so far - may exceed buf_len after an overflow
+size_t atomic_arena_used(AtomicArena *a) {
+  return __atomic_load_n(&a->curr_offset, __ATOMIC_RELAXED);
+}
+
+// Only safe once every thread is done with the memory
+void atomic_arena_reset(AtomicArena *a) {
+  __atomic_store_n(&a->curr_offset, 0, __ATOMIC_RELEASE);
+}
+
+typedef struct ThreadArena {
+  AtomicArena *parent;
+  Arena block; // current private block - a plain, non-atomic Arena
+  size_t block_size;
+} ThreadArena;
+
+void thread_arena_init(ThreadArena *t, AtomicArena *parent,
+                       size_t block_size) {
+  memset(t, 0, sizeof(*t));
+  t->parent = parent;
+  t->block_size = block_size;
+}
+
+void *thread_arena_alloc_align_flags(ThreadArena *t, size_t size,
+                                     size_t align, ArenaFlags flags) {
+  uintptr_t curr_ptr = (uintptr_t)t->block.buf + t->block.curr_offset;
+  size_t offset = align_forward(curr_ptr, align) - (uintptr_t)t->block.buf;
+  if (!t->block.buf || offset + size > t->block.buf_len) {
+    // Grab a fresh block - whatever was left of the old one is wasted
+    size_t block_size = t->block_size;
+    if (size + align > block_size) {
+      block_size = size + align;
+    }
+    void *block = atomic_arena_alloc_align_flags(
+        t->parent, block_size, ATOMIC_ARENA_ALIGNMENT, arena_flag_no_zero);
+    if (!block) {
+      return NULL;
+    }
+    arena_init(&t->block, block, block_size);
+  }
+  return arena_alloc_align_flags(&t->block, size, align, arena_tag_threads,
+                                 flags);
+}
+
+void *thread_arena_alloc(ThreadArena *t, size_t size) {
+  return thread_arena_alloc_align_flags(t, size, DEFAULT_ALIGNMENT,
+                                        arena_flags_none);
+}
+
+void *thread_arena_alloc_nozero(ThreadArena *t, size_t size) {
+  return thread_arena_alloc_align_flags(t, size, DEFAULT_ALIGNMENT,
+                                        arena_flag_no_zero);
+}
+
+// Call after the parent has been reset so the stale block isn't reused
+void thread_arena_reset(ThreadArena *t) {
+  memset(&t->block, 0, sizeof(t->block));
+}
@@ -0,0 +1,665 @@
+//
+// Autosave
+//
+// Writes only what changed. Chunks the player has modified are flagged
+// unsaved whenever something in them is spawned, destroyed or damaged (see
+// world_mark_chunk_unsaved), and every so often the game thread copies just
+// those chunks' entities into a staging buffer. A writer thread takes the
+// buffer from there, compresses each chunk (compress.c) and writes it to its
+// own file, then writes the small world file - seed, player, inventory, time
+// and which chunks have files - last. Every file goes to a temporary name
+// first and is renamed over the old one, so a crash mid-autosave leaves the
+// previous version of each file.
+//
+// The world file lists only chunks whose file has been written. A chunk
+// whose file couldn't be written is flagged unsaved again once the writer
+// reports back, so the next autosave retries it, and so does one that was
+// left for later because the staging buffer was full.
+//
+// Unmodified chunks are never saved - loading regenerates them from the seed.
+//
+// The other mode, autosave_fork, writes the whole World as a save (save.c)
+// to <dir>/world.sav from a forked child - never over the player's own
+// save. The child has the session arena exactly as it was at the fork and
+// the kernel only copies a page once either side writes to it. The game
+// pauses for fork() copying the page tables of everything resident, and
+// then for a fault on the first write to each shared page while the child
+// runs. Big buffers a child never reads (the rewind ring) are left out of
+// the fork, which keeps the pause to a few tenths of a ms against ~5 ms
+// for saving inline (the autosave bench). The game checks on the child
+// each tick without waiting for it.
+//
+//   <dir>/world.dat          AutosaveWorld, then ChunkCoord[chunkCount]
+//   <dir>/chunk_X_Y.dat      AutosaveChunk, then the encoded SavedEntity[]
+//   <dir>/world.sav          autosave_fork's save
+//
+
+#include <sys/wait.h>
+
+#define AUTOSAVE_MAGIC "FTTAUTO"
+#define AUTOSAVE_VERSION 1
+#define AUTOSAVE_DIR "autosave"
+#define AUTOSAVE_FORK_FILE "world.sav"
+#define AUTOSAVE_FORK_PATH AUTOSAVE_DIR "/" AUTOSAVE_FORK_FILE
+#define AUTOSAVE_MAX_CHUNKS 256 // staged per autosave - the rest wait
+#define AUTOSAVE_STAGING_SIZE MB(8)
+
+const float autosaveIntervalSeconds = 10;
+const long autosaveIdleSleepNs = 10000000;
+
+typedef enum AutosaveMode {
+  autosave_chunks = 0, // changed chunks from the writer thread
+  autosave_fork,       // the whole World from a child process
+  AUTOSAVE_MODE_MAX
+} AutosaveMode;
+
+const char *autosaveModeNames[AUTOSAVE_MODE_MAX] = {
+    [autosave_chunks] = "chunks",
+    [autosave_fork] = "fork",
+};
+
+// How a chunk's entities are stored in its file
+typedef enum SaveCodec {
+  save_codec_none = 0,
+  save_codec_lz, // compress.c
+  SAVE_CODEC_MAX
+} SaveCodec;
+
+// An entity and the per-entity arrays World keeps beside it
+typedef struct SavedEntity {
+  Entity entity;
+  float bobAmplitude;
+  float bobPhaseCos;
+  float bobPhaseSin;
+  float animStart;
+  uint8_t animClip;
+} SavedEntity;
+
+typedef struct AutosaveWorld {
+  char magic[8];
+  uint32_t version;
+  uint32_t seed;
+  int inventory[MAX_INVENTORY_COUNT];
+  int timeInMinutes;
+  double timeElapsed;
+  int dayCount;
+  float energy;
+  float hydration;
+  double animClock;
+  bool playerFacingLeft;
+  SavedEntity player;
+  Camera2D camera;
+  uint32_t chunkCount; // the modified chunks that have a file
+} AutosaveWorld;
+
+typedef struct AutosaveChunk {
+  char magic[8];
+  uint32_t version;
+  uint32_t codec; // SaveCodec
+  uint32_t seed;  // the World it belongs to
+  ChunkCoord coord;
+  uint32_t entityCount;
+  uint64_t size; // bytes that follow, encoded
+} AutosaveChunk;
+
+// Chunks the autosave directory has a file for, from this World
+HASHMAP_DEFINE(ChunkCoord, bool, ChunkSet, chunk_set, hash_chunk_coord,
+               chunk_coord_eq)
+
+typedef struct Autosaver {
+  // Game thread only
+  AutosaveMode mode;
+  float sinceLast; // seconds
+  uint32_t *indices; // entities being staged, MAX_ENTITY_COUNT
+  uint16_t *slots;   // which staged chunk each index goes to
+  uint64_t stageNs;  // spent staging the last autosave
+  int stagedChunks;
+  ChunkCoord stagedCoords[AUTOSAVE_MAX_CHUNKS];
+  bool awaitingResults; // the writer hasn't reported on stagedCoords yet
+  ChunkSet filed;
+  bool running; // false if the thread couldn't start
+  pthread_t thread;
+  // autosave_fork
+  pid_t child; // 0 when there isn't one
+  uint64_t forkStartNs;
+  uint64_t forkPauseNs; // the game's pause for the last fork
+  uint64_t forkNs;      // from the fork until the child was reaped
+  int forkFailures;
+  // Shared - the staging buffer belongs to whoever pending says
+  unsigned char *staging;
+  size_t worldBytes;  // room for AutosaveWorld and its coords at the front
+  size_t stagedBytes; // then stagedChunks chunk records
+  bool newFile[AUTOSAVE_MAX_CHUNKS]; // staged chunks not in filed
+  int pending;        // __atomic builtins only - 1 while the writer has it
+  int quit;           // __atomic builtins only
+  // Written by the writer while pending
+  unsigned char *encoded; // one chunk's file at a time
+  size_t encodedCapacity;
+  bool written[AUTOSAVE_MAX_CHUNKS]; // per staged chunk
+  uint64_t writeNs;       // the last autosave's
+  uint64_t bytesWritten;  // totals
+  int chunksWritten;
+  int failures;
+  char dir[128];
+} Autosaver;
+
+bool autosave_write_file(Autosaver *a, const char *name, const void *data,
+                         size_t size) {
+  char path[256], tempPath[256];
+  snprintf(path, sizeof(path), "%s/%s", a->dir, name);
+  snprintf(tempPath, sizeof(tempPath), "%s/%s.tmp", a->dir, name);
+  int fd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  bool ok = save_write_all(fd, data, size);
+  ok = close(fd) == 0 && ok;
+  if (ok) {
+    ok = rename(tempPath, path) == 0;
+  }
+  if (!ok) {
+    unlink(tempPath);
+  }
+  return ok;
+}
+
+// Writer thread, or the game thread without one - writes what was staged
+void autosave_write(Autosaver *a) {
+  uint64_t start = stream_now_ns();
+  mkdir(a->dir, 0755);
+
+  // Chunks first, so the world file never lists a chunk older than itself
+  // or one without a file
+  AutosaveWorld *worldFile = (AutosaveWorld *)a->staging;
+  ChunkCoord *coords = (ChunkCoord *)(worldFile + 1);
+  unsigned char *cursor = a->staging + align_forward(a->worldBytes, 8);
+  unsigned char *end = a->staging + a->stagedBytes;
+  for (int slot = 0; cursor < end; slot++) {
+    AutosaveChunk *staged = (AutosaveChunk *)cursor;
+    size_t rawSize = staged->entityCount * sizeof(SavedEntity);
+    AutosaveChunk *header = (AutosaveChunk *)a->encoded;
+    *header = *staged;
+    header->codec = save_codec_lz;
+    header->size = lz_compress(staged + 1, rawSize, header + 1,
+                               a->encodedCapacity - sizeof(*header));
+    if (header->size == 0 || header->size >= rawSize) {
+      header->codec = save_codec_none;
+      header->size = rawSize;
+      memcpy(header + 1, staged + 1, rawSize);
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "chunk_%d_%d.dat", staged->coord.x,
+             staged->coord.y);
+    size_t fileSize = sizeof(*header) + header->size;
+    a->written[slot] = autosave_write_file(a, name, header, fileSize);
+    if (a->written[slot]) {
+      a->bytesWritten += fileSize;
+      a->chunksWritten++;
+      if (a->newFile[slot]) {
+        coords[worldFile->chunkCount++] = staged->coord;
+      }
+    } else {
+      a->failures++;
+    }
+    cursor += align_forward(sizeof(*staged) + rawSize, 8);
+  }
+
+  size_t worldBytes =
+      sizeof(*worldFile) + worldFile->chunkCount * sizeof(ChunkCoord);
+  if (autosave_write_file(a, "world.dat", a->staging, worldBytes)) {
+    a->bytesWritten += worldBytes;
+  } else {
+    a->failures++;
+  }
+  a->writeNs = stream_now_ns() - start;
+}
+
+void *autosave_worker(void *arg) {
+  Autosaver *a = arg;
+  struct timespec idle = {0, autosaveIdleSleepNs};
+  for (;;) {
+    if (__atomic_load_n(&a->pending, __ATOMIC_ACQUIRE)) {
+      autosave_write(a);
+      __atomic_store_n(&a->pending, 0, __ATOMIC_RELEASE);
+      continue;
+    }
+    // only once nothing is left to write
+    if (__atomic_load_n(&a->quit, __ATOMIC_ACQUIRE)) {
+      break;
+    }
+    nanosleep(&idle, NULL);
+  }
+  return NULL;
+}
+
+// Starts the writer. If the thread can't be started autosaves are written
+// on the game thread.
+bool InitAutosaver(Autosaver *a, Arena *arena, const char *dir) {
+  memset(a, 0, sizeof(*a));
+  snprintf(a->dir, sizeof(a->dir), "%s", dir);
+  a->indices = arena_alloc(arena, MAX_ENTITY_COUNT * sizeof(*a->indices));
+  a->slots = arena_alloc(arena, MAX_ENTITY_COUNT * sizeof(*a->slots));
+  a->staging = arena_alloc_nozero(arena, AUTOSAVE_STAGING_SIZE);
+  // a chunk can be as big as the staging buffer
+  a->encodedCapacity =
+      sizeof(AutosaveChunk) + lz_compress_bound(AUTOSAVE_STAGING_SIZE);
+  a->encoded = arena_alloc_nozero(arena, a->encodedCapacity);
+  if (!a->indices || !a->slots || !a->staging || !a->encoded ||
+      !chunk_set_init(&a->filed, arena, AUTOSAVE_MAX_CHUNKS)) {
+    return false;
+  }
+  a->running = pthread_create(&a->thread, NULL, autosave_worker, a) == 0;
+  if (!a->running) {
+    fprintf(stderr, "autosave: no writer thread, writing inline\n");
+  }
+  return true;
+}
+
+void ReapAutosaveChild(Autosaver *a, bool wait);
+
+// Finishes the autosave being written, if any
+void UnloadAutosaver(Autosaver *a) {
+  ReapAutosaveChild(a, true);
+  if (a->running) {
+    __atomic_store_n(&a->quit, 1, __ATOMIC_RELEASE);
+    pthread_join(a->thread, NULL);
+    a->running = false;
+  }
+}
+
+bool AutosaveBusy(Autosaver *a) {
+  return __atomic_load_n(&a->pending, __ATOMIC_ACQUIRE) != 0;
+}
+
+// Takes the writer's report on the last autosave once it's done
+void autosave_collect(Autosaver *a, World *world) {
+  if (!a->awaitingResults || AutosaveBusy(a)) {
+    return;
+  }
+  for (int c = 0; c < a->stagedChunks; c++) {
+    ChunkCoord coord = a->stagedCoords[c];
+    if (a->written[c] && chunk_set_put(&a->filed, coord)) {
+      continue;
+    }
+    ChunkInfo *info = chunk_table_get(&world->chunks, coord);
+    if (info && info->modified) {
+      info->unsaved = true; // retried next time
+    }
+  }
+  a->awaitingResults = false;
+}
+
+// The files already written are from another World once it's replaced (a
+// new game, a load, a rewind), so every modified chunk is written again
+void ResetAutosaver(Autosaver *a, World *world) {
+  struct timespec wait = {0, 100000};
+  while (AutosaveBusy(a)) {
+    nanosleep(&wait, NULL);
+  }
+  a->awaitingResults = false;
+  chunk_set_clear(&a->filed);
+  a->sinceLast = 0;
+  for (size_t i = 0; i < world->chunks.capacity; i++) {
+    ChunkTableEntry *entry = &world->chunks.entries[i];
+    if (entry->hash && entry->value.modified) {
+      entry->value.unsaved = true;
+    }
+  }
+}
+
+SavedEntity save_entity(World *world, Entity *entity) {
+  int i = entity - world->entities;
+  SavedEntity saved;
+  memset(&saved, 0, sizeof(saved)); // no stray padding bytes in the files
+  saved.entity = *entity;
+  saved.bobAmplitude = world->bobAmplitude[i];
+  saved.bobPhaseCos = world->bobPhaseCos[i];
+  saved.bobPhaseSin = world->bobPhaseSin[i];
+  saved.animStart = world->animStart[i];
+  saved.animClip = world->animClip[i];
+  return saved;
+}
+
+void restore_entity(World *world, Entity *entity, SavedEntity *saved) {
+  int i = entity - world->entities;
+  *entity = saved->entity;
+  world->bobAmplitude[i] = saved->bobAmplitude;
+  world->bobPhaseCos[i] = saved->bobPhaseCos;
+  world->bobPhaseSin[i] = saved->bobPhaseSin;
+  world->animStart[i] = saved->animStart;
+  world->animClip[i] = saved->animClip;
+  world->animFrame[i] = animClips[saved->animClip].firstFrame;
+}
+
+// Copies the unsaved chunks into the staging buffer and hands it to the
+// writer. Returns false if the writer still has the last one.
+bool StageAutosave(Autosaver *a, World *world) {
+  if (AutosaveBusy(a)) {
+    return false;
+  }
+  autosave_collect(a, world);
+  uint64_t start = stream_now_ns();
+
+  // Modified chunks that already have a file go in the world file's list,
+  // the unsaved ones are staged and the writer adds those new to the list
+  // once their files are written
+  ChunkTableEntry *staged[AUTOSAVE_MAX_CHUNKS];
+  int stagedCount = 0;
+  AutosaveWorld *header = (AutosaveWorld *)a->staging;
+  ChunkCoord *coords = (ChunkCoord *)(header + 1);
+  // the list gets at most half the buffer
+  size_t maxCoords =
+      (AUTOSAVE_STAGING_SIZE / 2 - sizeof(*header)) / sizeof(ChunkCoord) -
+      AUTOSAVE_MAX_CHUNKS;
+  uint32_t coordCount = 0;
+  for (size_t i = 0; i < world->chunks.capacity; i++) {
+    ChunkTableEntry *entry = &world->chunks.entries[i];
+    if (!entry->hash || !entry->value.modified) {
+      continue;
+    }
+    bool filed = chunk_set_get(&a->filed, entry->key) != NULL;
+    if (filed && coordCount < maxCoords) {
+      coords[coordCount++] = entry->key;
+    }
+    if (entry->value.unsaved && stagedCount < AUTOSAVE_MAX_CHUNKS) {
+      a->newFile[stagedCount] = !filed;
+      staged[stagedCount++] = entry;
+    }
+  }
+
+  // World is one flat array rather than per chunk, so one pass finds what's
+  // in the staged chunks. Anything outside the box around them (plus a tile
+  // for entity_chunk's rounding) is skipped without working out its chunk,
+  // and entities are spawned a chunk at a time so the last match is usually
+  // the next one too.
+  Rectangle box = {0};
+  for (int c = 0; c < stagedCount; c++) {
+    ChunkCoord coord = staged[c]->key;
+    Rectangle bounds = {(coord.x * chunkWidth) - tileWidth,
+                        (coord.y * chunkWidth) - tileWidth,
+                        chunkWidth + 2 * tileWidth, chunkWidth + 2 * tileWidth};
+    if (c == 0) {
+      box = bounds;
+      continue;
+    }
+    float right = fmaxf(box.x + box.width, bounds.x + bounds.width);
+    float bottom = fmaxf(box.y + box.height, bounds.y + bounds.height);
+    box.x = fminf(box.x, bounds.x);
+    box.y = fminf(box.y, bounds.y);
+    box.width = right - box.x;
+    box.height = bottom - box.y;
+  }
+  uint32_t counts[AUTOSAVE_MAX_CHUNKS] = {0};
+  int found = 0;
+  int last = 0;
+  for (int i = 0; stagedCount > 0 && i < world->entityHighWater; i++) {
+    Entity *entity = &world->entities[i];
+    Vector2 pos = entity->pos;
+    if (!entity->is_valid || entity == world->player || pos.x < box.x ||
+        pos.y < box.y || pos.x >= box.x + box.width ||
+        pos.y >= box.y + box.height) {
+      continue;
+    }
+    ChunkCoord coord = entity_chunk(entity);
+    if (!chunk_coord_eq(coord, staged[last]->key)) {
+      last = -1;
+      for (int c = 0; c < stagedCount; c++) {
+        if (chunk_coord_eq(coord, staged[c]->key)) {
+          last = c;
+          break;
+        }
+      }
+      if (last < 0) {
+        last = 0;
+        continue;
+      }
+    }
+    a->indices[found] = i;
+    a->slots[found] = last;
+    found++;
+    counts[last]++;
+  }
+
+  // Lay the chunk records out, leaving any that don't fit for next time
+  size_t worldBytes =
+      sizeof(*header) + (coordCount + stagedCount) * sizeof(ChunkCoord);
+  size_t offsets[AUTOSAVE_MAX_CHUNKS];
+  size_t size = align_forward(worldBytes, 8);
+  int fits = 0;
+  for (; fits < stagedCount; fits++) {
+    size_t record = align_forward(
+        sizeof(AutosaveChunk) + counts[fits] * sizeof(SavedEntity), 8);
+    if (size + record > AUTOSAVE_STAGING_SIZE) {
+      break;
+    }
+    offsets[fits] = size;
+    AutosaveChunk *chunk = (AutosaveChunk *)(a->staging + size);
+    *chunk = (AutosaveChunk){.magic = AUTOSAVE_MAGIC,
+                             .version = AUTOSAVE_VERSION,
+                             .seed = world->seed,
+                             .coord = staged[fits]->key,
+                             .entityCount = counts[fits]};
+    size += record;
+    offsets[fits] += sizeof(AutosaveChunk); // where its next entity goes
+    // set again if the writer couldn't write it, so changes made while it's
+    // being written aren't lost either way
+    staged[fits]->value.unsaved = false;
+    a->stagedCoords[fits] = staged[fits]->key;
+  }
+  for (int e = 0; e < found; e++) {
+    int slot = a->slots[e];
+    if (slot < fits) {
+      Entity *entity = &world->entities[a->indices[e]];
+      SavedEntity saved = save_entity(world, entity);
+      memcpy(a->staging + offsets[slot], &saved, sizeof(saved));
+      offsets[slot] += sizeof(saved);
+    }
+  }
+
+  *header = (AutosaveWorld){.magic = AUTOSAVE_MAGIC,
+                            .version = AUTOSAVE_VERSION,
+                            .seed = world->seed,
+                            .timeInMinutes = world->timeInMinutes,
+                            .timeElapsed = world->timeElapsed,
+                            .dayCount = world->dayCount,
+                            .energy = world->energy,
+                            .hydration = world->hydration,
+                            .animClock = world->animClock,
+                            .playerFacingLeft = world->playerFacingLeft,
+                            .player = save_entity(world, world->player),
+                            .camera = world->camera,
+                            .chunkCount = coordCount};
+  memcpy(header->inventory, world->inventory, sizeof(header->inventory));
+  // the chunk records start 8-byte aligned
+  memset(a->staging + worldBytes, 0, align_forward(worldBytes, 8) - worldBytes);
+  a->worldBytes = worldBytes;
+  a->stagedBytes = size;
+  a->stagedChunks = fits;
+  a->awaitingResults = true;
+  a->stageNs = stream_now_ns() - start;
+
+  if (a->running) {
+    __atomic_store_n(&a->pending, 1, __ATOMIC_RELEASE);
+  } else {
+    autosave_write(a);
+    autosave_collect(a, world);
+  }
+  return true;
+}
+
+// Forks a child that writes the World to path and exits. Returns false if
+// the last one hasn't finished or there's no fork. The pause is the fork()
+// call, which grows with resident memory - see exclude_from_fork.
+bool ForkAutosave(Autosaver *a, World *world, const char *path) {
+  if (a->child > 0) {
+    return false;
+  }
+  mkdir(a->dir, 0755);
+  uint64_t start = stream_now_ns();
+  pid_t child = fork();
+  if (child == 0) {
+    // Only this thread exists in the child - no stdio, no locks, no atexit
+    Arena scratch;
+    arena_init(&scratch, a->encoded, a->encodedCapacity);
+    _exit(SaveGame(world, &scratch, path) ? 0 : 1);
+  }
+  a->forkPauseNs = stream_now_ns() - start;
+  if (child < 0) {
+    a->forkFailures++;
+    return false;
+  }
+  a->child = child;
+  a->forkStartNs = start;
+  return true;
+}
+
+// Collects the child once it's exited - or waits for it
+void ReapAutosaveChild(Autosaver *a, bool wait) {
+  if (a->child <= 0) {
+    return;
+  }
+  int status;
+  pid_t done = waitpid(a->child, &status, wait ? 0 : WNOHANG);
+  if (done == 0) {
+    return; // still writing
+  }
+  if (done < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    a->forkFailures++;
+  }
+  a->forkNs = stream_now_ns() - a->forkStartNs;
+  a->child = 0;
+}
+
+// Once per tick - autosaves every autosaveIntervalSeconds
+void UpdateAutosave(Autosaver *a, World *world, float deltaT) {
+  ReapAutosaveChild(a, false);
+  autosave_collect(a, world);
+  a->sinceLast += deltaT;
+  if (a->sinceLast < autosaveIntervalSeconds) {
+    return;
+  }
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", a->dir, AUTOSAVE_FORK_FILE);
+  bool started = a->mode == autosave_fork ? ForkAutosave(a, world, path)
+                                          : StageAutosave(a, world);
+  if (started) {
+    a->sinceLast = 0;
+  }
+}
+
+// Reads a whole file into arena, NULL if it can't
+void *autosave_read_file(Arena *arena, const char *path, size_t *size) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat info;
+  unsigned char *data = NULL;
+  if (fstat(fd, &info) == 0 &&
+      (data = arena_alloc_nozero(arena, info.st_size + 1))) {
+    size_t got = 0;
+    while (got < (size_t)info.st_size) {
+      ssize_t n = read(fd, data + got, info.st_size - got);
+      if (n <= 0) {
+        data = NULL;
+        break;
+      }
+      got += n;
+    }
+    *size = got;
+  }
+  close(fd);
+  return data;
+}
+
+// Spawns a chunk's saved entities. Returns false if the file's missing or
+// isn't from this World, in which case the chunk regenerates from the seed.
+bool autosave_load_chunk(World *world, Arena *scratch, const char *dir,
+                         ChunkCoord coord) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/chunk_%d_%d.dat", dir, coord.x, coord.y);
+  size_t size = 0;
+  AutosaveChunk *header = autosave_read_file(scratch, path, &size);
+  if (!header || size < sizeof(*header) ||
+      memcmp(header->magic, AUTOSAVE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != AUTOSAVE_VERSION || header->seed != world->seed ||
+      !chunk_coord_eq(header->coord, coord) ||
+      header->size != size - sizeof(*header)) {
+    return false;
+  }
+  if (header->entityCount > MAX_ENTITY_COUNT) {
+    return false;
+  }
+  size_t rawSize = header->entityCount * sizeof(SavedEntity);
+  SavedEntity *entities = (SavedEntity *)(header + 1);
+  if (header->codec == save_codec_lz) {
+    entities = arena_alloc_nozero(scratch, rawSize);
+    if (!entities ||
+        !lz_decompress(header + 1, header->size, entities, rawSize)) {
+      return false;
+    }
+  } else if (header->codec != save_codec_none || header->size != rawSize) {
+    return false;
+  }
+
+  ChunkInfo *info = chunk_table_put(&world->chunks, coord);
+  if (!info) {
+    return false;
+  }
+  info->state = chunk_loaded;
+  info->modified = true;
+  for (uint32_t i = 0; i < header->entityCount; i++) {
+    Entity *entity = entity_create();
+    if (!entity) {
+      break;
+    }
+    SavedEntity saved;
+    memcpy(&saved, &entities[i], sizeof(saved));
+    restore_entity(world, entity, &saved);
+  }
+  return true;
+}
+
+// Starts a session from the autosave in dir, like StartSession. Returns NULL
+// and leaves the current World alone if there isn't one this build can read.
+World *LoadAutosave(GameMemory *memory, const char *dir) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/world.dat", dir);
+  Arena *scratch = FrameArena(memory);
+  size_t size = 0;
+  AutosaveWorld *header = autosave_read_file(scratch, path, &size);
+  if (!header || size < sizeof(*header) ||
+      memcmp(header->magic, AUTOSAVE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != AUTOSAVE_VERSION ||
+      size != sizeof(*header) + header->chunkCount * sizeof(ChunkCoord)) {
+    return NULL;
+  }
+
+  // header is in the frame arena, which StartSession leaves alone
+  if (!StartSession(memory, header->seed)) {
+    return NULL;
+  }
+  ReleaseLoadedSave();
+  memcpy(world->inventory, header->inventory, sizeof(world->inventory));
+  world->timeInMinutes = header->timeInMinutes;
+  world->timeElapsed = header->timeElapsed;
+  world->dayCount = header->dayCount;
+  world->energy = header->energy;
+  world->hydration = header->hydration;
+  world->animClock = header->animClock;
+  world->playerFacingLeft = header->playerFacingLeft;
+  restore_entity(world, world->player, &header->player);
+  world->camera = header->camera;
+
+  ChunkCoord *coords = (ChunkCoord *)(header + 1);
+  for (uint32_t i = 0; i < header->chunkCount; i++) {
+    ChunkCoord coord;
+    memcpy(&coord, &coords[i], sizeof(coord));
+    if (!autosave_load_chunk(world, scratch, dir, coord)) {
+      fprintf(stderr, "autosave: chunk %d,%d regenerates\n", coord.x,
+              coord.y);
+    }
+  }
+  return world;
+}
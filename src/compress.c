@@ -0,0 +1,224 @@
+//
+// Block compression
+//
+// A byte-oriented LZ77 in the LZ4 mould, built for decompressing fast
+// rather than compressing small. A block is a run of sequences, each
+//
+//   token | literal length ext | literals | offset (2 bytes LE) | match ext
+//
+// where the token's high nibble is the literal count and its low nibble the
+// match length minus LZ_MIN_MATCH; a nibble of 15 continues into bytes that
+// add up until one isn't 255. The last sequence is literals only and ends
+// the block. Matches reach back at most 64 KB and blocks are under 4 GB.
+//
+// Decompression copies in 8 and 16 byte steps whenever the output has room
+// for the overshoot, and checks every length and offset against both
+// buffers, so a corrupt block is rejected rather than read or written past.
+//
+
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+#define LZ_HASH_BITS 12
+// Unmatched stretches are skipped through faster the longer they get
+#define LZ_SKIP_SHIFT 5
+
+uint32_t lz_read32(const unsigned char *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint64_t lz_read64(const unsigned char *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint32_t lz_hash(uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Worst case - everything is literals
+size_t lz_compress_bound(size_t size) { return size + size / 255 + 16; }
+
+unsigned char *lz_write_length(unsigned char *out, size_t length) {
+  while (length >= 255) {
+    *out++ = 255;
+    length -= 255;
+  }
+  *out++ = (unsigned char)length;
+  return out;
+}
+
+unsigned char *lz_write_sequence(unsigned char *out,
+                                 const unsigned char *literals,
+                                 size_t literalCount, size_t offset,
+                                 size_t matchLength) {
+  size_t match = matchLength ? matchLength - LZ_MIN_MATCH : 0;
+  unsigned char *token = out++;
+  *token = (unsigned char)((literalCount < 15 ? literalCount : 15) << 4 |
+                           (match < 15 ? match : 15));
+  if (literalCount >= 15) {
+    out = lz_write_length(out, literalCount - 15);
+  }
+  memcpy(out, literals, literalCount);
+  out += literalCount;
+  if (matchLength) {
+    *out++ = (unsigned char)offset;
+    *out++ = (unsigned char)(offset >> 8);
+    if (match >= 15) {
+      out = lz_write_length(out, match - 15);
+    }
+  }
+  return out;
+}
+
+// Length of the common prefix of a and b, at most limit bytes
+size_t lz_match_length(const unsigned char *a, const unsigned char *b,
+                       size_t limit) {
+  size_t length = 0;
+  while (length + 8 <= limit) {
+    uint64_t diff = lz_read64(a + length) ^ lz_read64(b + length);
+    if (diff) {
+      return length + __builtin_ctzll(diff) / 8; // little-endian
+    }
+    length += 8;
+  }
+  while (length < limit && a[length] == b[length]) {
+    length++;
+  }
+  return length;
+}
+
+// Returns the compressed size, or 0 if capacity is under
+// lz_compress_bound(size)
+size_t lz_compress(const void *source, size_t size, void *dest,
+                   size_t capacity) {
+  if (capacity < lz_compress_bound(size)) {
+    return 0;
+  }
+  const unsigned char *src = source;
+  unsigned char *out = dest;
+  uint32_t table[1 << LZ_HASH_BITS];
+  memset(table, 0, sizeof(table));
+
+  size_t anchor = 0; // first byte not yet written
+  size_t pos = 1;    // 0 is where every empty table slot points
+  while (size >= LZ_MIN_MATCH && pos <= size - LZ_MIN_MATCH) {
+    uint32_t sequence = lz_read32(src + pos);
+    uint32_t hash = lz_hash(sequence);
+    size_t candidate = table[hash];
+    table[hash] = (uint32_t)pos;
+    if (pos - candidate > LZ_MAX_OFFSET ||
+        lz_read32(src + candidate) != sequence) {
+      pos += 1 + ((pos - anchor) >> LZ_SKIP_SHIFT);
+      continue;
+    }
+
+    size_t length =
+        LZ_MIN_MATCH + lz_match_length(src + pos + LZ_MIN_MATCH,
+                                       src + candidate + LZ_MIN_MATCH,
+                                       size - pos - LZ_MIN_MATCH);
+    // the match may have started before the hash found it
+    while (pos > anchor && candidate > 0 &&
+           src[pos - 1] == src[candidate - 1]) {
+      pos--;
+      candidate--;
+      length++;
+    }
+    out = lz_write_sequence(out, src + anchor, pos - anchor, pos - candidate,
+                            length);
+    pos += length;
+    anchor = pos;
+  }
+  out = lz_write_sequence(out, src + anchor, size - anchor, 0, 0);
+  return out - (unsigned char *)dest;
+}
+
+// Reads a nibble's continuation bytes. Returns false if it runs off the end.
+bool lz_read_length(const unsigned char **src, const unsigned char *end,
+                    size_t *length) {
+  unsigned char byte;
+  do {
+    if (*src >= end) {
+      return false;
+    }
+    byte = *(*src)++;
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+// Decompresses exactly rawSize bytes into dest. Returns false if the block
+// is corrupt or doesn't decompress to rawSize.
+bool lz_decompress(const void *source, size_t size, void *dest,
+                   size_t rawSize) {
+  const unsigned char *src = source;
+  const unsigned char *end = src + size;
+  unsigned char *out = dest;
+  unsigned char *outEnd = out + rawSize;
+
+  for (;;) {
+    if (src >= end) {
+      return false; // the literals-only sequence is missing
+    }
+    unsigned token = *src++;
+    size_t literals = token >> 4;
+    if (literals == 15 && !lz_read_length(&src, end, &literals)) {
+      return false;
+    }
+    if (literals > (size_t)(end - src) || literals > (size_t)(outEnd - out)) {
+      return false;
+    }
+    if (literals <= 16 && end - src >= 16 && outEnd - out >= 16) {
+      memcpy(out, src, 16); // the rest is overwritten or past the end
+    } else {
+      memcpy(out, src, literals);
+    }
+    out += literals;
+    src += literals;
+    if (src == end) {
+      break; // the last sequence has no match
+    }
+
+    if (end - src < 2) {
+      return false;
+    }
+    size_t offset = src[0] | (size_t)src[1] << 8;
+    src += 2;
+    size_t match = token & 15;
+    if (match == 15 && !lz_read_length(&src, end, &match)) {
+      return false;
+    }
+    match += LZ_MIN_MATCH;
+    if (offset == 0 || offset > (size_t)(out - (unsigned char *)dest) ||
+        match > (size_t)(outEnd - out)) {
+      return false;
+    }
+
+    const unsigned char *from = out - offset;
+    if ((size_t)(outEnd - out) >= match + 8) {
+      // A short offset is a repeating pattern - copy it out to a period of
+      // at least 8 bytes, after which each step reads only final bytes
+      size_t i = 0;
+      size_t period = offset;
+      if (offset < 8) {
+        while (period < 8) {
+          period += offset;
+        }
+        for (; i < period && i < match; i++) {
+          out[i] = from[i];
+        }
+      }
+      for (; i < match; i += 8) {
+        memcpy(out + i, out + i - period, 8);
+      }
+    } else {
+      for (size_t i = 0; i < match; i++) {
+        out[i] = from[i];
+      }
+    }
+    out += match;
+  }
+  return out == outEnd;
+}
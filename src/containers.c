@@ -0,0 +1,323 @@
+//
+// Arena-backed generic containers
+//
+// Both are generated per type with a macro so they're type-safe without
+// void* casts at every call site. Memory comes from the Arena passed at init
+// and is never freed individually - it goes away when that arena is reset.
+//
+
+//
+// Dynamic array
+//
+// Grows by doubling through arena_resize, so while the array is the arena's
+// most recent allocation it grows in place with no copy. Otherwise the old
+// items are copied and the old block is left for the arena reset.
+//
+//   DARRAY_DEFINE(Entity *, EntityList, entity_list)
+//   EntityList list;
+//   entity_list_init(&list, frameArena, 64);
+//   entity_list_append(&list, world->player);
+//
+
+#define DARRAY_DEFINE(Type, ArrayType, prefix)                                 \
+  typedef struct ArrayType {                                                   \
+    Type *items;                                                               \
+    size_t count;                                                              \
+    size_t capacity;                                                           \
+    Arena *arena;                                                              \
+  } ArrayType;                                                                 \
+                                                                               \
+  void prefix##_init(ArrayType *a, Arena *arena, size_t capacity) {            \
+    a->arena = arena;                                                          \
+    a->count = 0;                                                              \
+    a->capacity = 0;                                                           \
+    a->items = NULL;                                                           \
+    if (capacity) {                                                            \
+      a->items = arena_alloc_align(arena, capacity * sizeof(Type),             \
+                                   __alignof__(Type));                         \
+      a->capacity = a->items ? capacity : 0;                                   \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  bool prefix##_reserve(ArrayType *a, size_t capacity) {                       \
+    if (capacity <= a->capacity) {                                             \
+      return true;                                                             \
+    }                                                                          \
+    size_t new_capacity = a->capacity ? a->capacity * 2 : 8;                   \
+    while (new_capacity < capacity) {                                          \
+      new_capacity *= 2;                                                       \
+    }                                                                          \
+    Type *items = arena_resize_align_flags(                                    \
+        a->arena, a->items, a->capacity * sizeof(Type),                        \
+        new_capacity * sizeof(Type), __alignof__(Type), arena_flag_no_zero);   \
+    if (!items) {                                                              \
+      return false;                                                            \
+    }                                                                          \
+    a->items = items;                                                          \
+    a->capacity = new_capacity;                                                \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /* Returns a zeroed slot at the end, or NULL if the arena is full */         \
+  Type *prefix##_push(ArrayType *a) {                                          \
+    if (!prefix##_reserve(a, a->count + 1)) {                                  \
+      return NULL;                                                             \
+    }                                                                          \
+    Type *item = &a->items[a->count++];                                        \
+    memset(item, 0, sizeof(Type));                                             \
+    return item;                                                               \
+  }                                                                            \
+                                                                               \
+  bool prefix##_append(ArrayType *a, Type value) {                             \
+    Type *item = prefix##_push(a);                                             \
+    if (item) {                                                                \
+      *item = value;                                                           \
+    }                                                                          \
+    return item != NULL;                                                       \
+  }                                                                            \
+                                                                               \
+  /* O(1) - moves the last item into the hole, so order isn't kept */         \
+  void prefix##_remove_swap(ArrayType *a, size_t index) {                      \
+    a->items[index] = a->items[--a->count];                                    \
+  }                                                                            \
+                                                                               \
+  void prefix##_clear(ArrayType *a) { a->count = 0; }
+
+//
+// Hash map - open addressing with Robin Hood probing
+//
+// Entries live in one flat array, capacity is a power of two and the probe
+// is linear. On insert an entry steals the slot of any entry that is closer
+// to its home than the newcomer, which keeps probe lengths short and even at
+// high load. Removal shifts the following run back instead of leaving
+// tombstones. A stored hash of 0 marks an empty slot.
+//
+//   HASHMAP_DEFINE(int, Entity *, EntityById, entity_by_id, hash_int, eq_int)
+//   EntityById map;
+//   entity_by_id_init(&map, &memory->session, 256);
+//   *entity_by_id_put(&map, 7) = entity;
+//   Entity **found = entity_by_id_get(&map, 7);
+//
+
+uint32_t hash_u64(uint64_t x) {
+  // splitmix64 finaliser
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  return (uint32_t)x;
+}
+
+uint32_t hash_int(int x) { return hash_u64((uint64_t)(uint32_t)x); }
+bool eq_int(int a, int b) { return a == b; }
+bool eq_u64(uint64_t a, uint64_t b) { return a == b; }
+
+#define HASHMAP_MAX_LOAD_NUMERATOR 7 // grow past 7/8 full
+#define HASHMAP_MAX_LOAD_DENOMINATOR 8
+
+#define HASHMAP_DEFINE(Key, Value, MapType, prefix, hash_fn, eq_fn)           \
+  typedef struct MapType##Entry {                                              \
+    uint32_t hash;                                                             \
+    Key key;                                                                   \
+    Value value;                                                               \
+  } MapType##Entry;                                                            \
+                                                                               \
+  typedef struct MapType {                                                     \
+    MapType##Entry *entries;                                                   \
+    size_t count;                                                              \
+    size_t capacity; /* always a power of two */                               \
+    Arena *arena;                                                              \
+  } MapType;                                                                   \
+                                                                               \
+  uint32_t prefix##_hash(Key key) {                                            \
+    uint32_t hash = hash_fn(key);                                              \
+    return hash ? hash : 1;                                                    \
+  }                                                                            \
+                                                                               \
+  size_t prefix##_distance(MapType *m, uint32_t hash, size_t slot) {           \
+    return (slot - (hash & (m->capacity - 1))) & (m->capacity - 1);            \
+  }                                                                            \
+                                                                               \
+  bool prefix##_init(MapType *m, Arena *arena, size_t capacity) {              \
+    size_t pow2 = 8;                                                           \
+    while (pow2 < capacity) {                                                  \
+      pow2 *= 2;                                                               \
+    }                                                                          \
+    m->arena = arena;                                                          \
+    m->count = 0;                                                              \
+    m->capacity = pow2;                                                        \
+    m->entries = arena_alloc_align(arena, pow2 * sizeof(MapType##Entry),       \
+                                   __alignof__(MapType##Entry));               \
+    return m->entries != NULL;                                                 \
+  }                                                                            \
+                                                                               \
+  /* Places an entry known not to be in the map, returns where it landed */    \
+  MapType##Entry *prefix##_insert_new(MapType *m, MapType##Entry entry) {      \
+    size_t mask = m->capacity - 1;                                             \
+    size_t slot = entry.hash & mask;                                           \
+    size_t distance = 0;                                                       \
+    MapType##Entry *placed = NULL;                                             \
+    for (;;) {                                                                 \
+      MapType##Entry *e = &m->entries[slot];                                   \
+      if (e->hash == 0) {                                                      \
+        *e = entry;                                                            \
+        return placed ? placed : e;                                            \
+      }                                                                        \
+      size_t existing = prefix##_distance(m, e->hash, slot);                   \
+      if (existing < distance) {                                               \
+        /* Robin Hood - the richer entry moves on */                           \
+        MapType##Entry displaced = *e;                                         \
+        *e = entry;                                                            \
+        if (!placed) {                                                         \
+          placed = e;                                                          \
+        }                                                                      \
+        entry = displaced;                                                     \
+        distance = existing;                                                   \
+      }                                                                        \
+      slot = (slot + 1) & mask;                                                \
+      distance++;                                                              \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  /* The old entries are left for the arena reset */                           \
+  bool prefix##_grow(MapType *m) {                                             \
+    MapType##Entry *old = m->entries;                                          \
+    size_t old_capacity = m->capacity;                                         \
+    MapType##Entry *entries =                                                  \
+        arena_alloc_align(m->arena, old_capacity * 2 * sizeof(MapType##Entry), \
+                          __alignof__(MapType##Entry));                        \
+    if (!entries) {                                                            \
+      return false;                                                            \
+    }                                                                          \
+    m->entries = entries;                                                      \
+    m->capacity = old_capacity * 2;                                            \
+    for (size_t i = 0; i < old_capacity; i++) {                                \
+      if (old[i].hash) {                                                       \
+        prefix##_insert_new(m, old[i]);                                        \
+      }                                                                        \
+    }                                                                          \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  long prefix##_find_slot(MapType *m, Key key) {                               \
+    uint32_t hash = prefix##_hash(key);                                        \
+    size_t mask = m->capacity - 1;                                             \
+    size_t slot = hash & mask;                                                 \
+    for (size_t distance = 0;; distance++) {                                   \
+      MapType##Entry *e = &m->entries[slot];                                   \
+      /* an empty slot or a richer entry means the key can't be further on */  \
+      if (e->hash == 0 || prefix##_distance(m, e->hash, slot) < distance) {    \
+        return -1;                                                             \
+      }                                                                        \
+      if (e->hash == hash && eq_fn(e->key, key)) {                             \
+        return (long)slot;                                                     \
+      }                                                                        \
+      slot = (slot + 1) & mask;                                                \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  Value *prefix##_get(MapType *m, Key key) {                                   \
+    long slot = prefix##_find_slot(m, key);                                    \
+    return slot < 0 ? NULL : &m->entries[slot].value;                          \
+  }                                                                            \
+                                                                               \
+  /* Returns the value for key, inserting a zeroed one if it was missing. */   \
+  /* NULL only if growing ran out of arena. */                                 \
+  Value *prefix##_put(MapType *m, Key key) {                                   \
+    long slot = prefix##_find_slot(m, key);                                    \
+    if (slot >= 0) {                                                           \
+      return &m->entries[slot].value;                                          \
+    }                                                                          \
+    if ((m->count + 1) * HASHMAP_MAX_LOAD_DENOMINATOR >                        \
+            m->capacity * HASHMAP_MAX_LOAD_NUMERATOR &&                        \
+        !prefix##_grow(m)) {                                                   \
+      return NULL;                                                             \
+    }                                                                          \
+    MapType##Entry entry;                                                      \
+    memset(&entry, 0, sizeof(entry));                                          \
+    entry.hash = prefix##_hash(key);                                           \
+    entry.key = key;                                                           \
+    m->count++;                                                                \
+    return &prefix##_insert_new(m, entry)->value;                              \
+  }                                                                            \
+                                                                               \
+  bool prefix##_remove(MapType *m, Key key) {                                  \
+    long found = prefix##_find_slot(m, key);                                   \
+    if (found < 0) {                                                           \
+      return false;                                                            \
+    }                                                                          \
+    size_t mask = m->capacity - 1;                                             \
+    size_t slot = (size_t)found;                                               \
+    /* backward shift - pull the rest of the run one slot closer to home */    \
+    for (;;) {                                                                 \
+      size_t next = (slot + 1) & mask;                                         \
+      MapType##Entry *e = &m->entries[next];                                   \
+      if (e->hash == 0 || prefix##_distance(m, e->hash, next) == 0) {          \
+        break;                                                                 \
+      }                                                                        \
+      m->entries[slot] = *e;                                                   \
+      slot = next;                                                             \
+    }                                                                          \
+    memset(&m->entries[slot], 0, sizeof(MapType##Entry));                      \
+    m->count--;                                                                \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  void prefix##_clear(MapType *m) {                                            \
+    memset(m->entries, 0, m->capacity * sizeof(MapType##Entry));               \
+    m->count = 0;                                                              \
+  }
+
+//
+// Single producer, single consumer queue - lock free
+//
+// A ring of pointers for handing work between exactly two threads. Only the
+// producer writes tail and only the consumer writes head, so each side needs
+// one acquire load of the other's index and one release store of its own -
+// no locks and no CAS. head and tail sit on separate cache lines so the two
+// threads don't fight over one.
+//
+
+typedef struct SpscQueue {
+  void **items;
+  size_t capacity; // always a power of two
+  size_t head __attribute__((aligned(64))); // next to pop
+  size_t tail __attribute__((aligned(64))); // next to push
+} SpscQueue;
+
+bool spsc_queue_init(SpscQueue *q, Arena *arena, size_t capacity) {
+  size_t pow2 = 2;
+  while (pow2 < capacity) {
+    pow2 *= 2;
+  }
+  memset(q, 0, sizeof(*q));
+  q->items = arena_alloc_tagged(arena, pow2 * sizeof(void *),
+                                arena_tag_threads);
+  q->capacity = q->items ? pow2 : 0;
+  return q->items != NULL;
+}
+
+// Producer only. False if the queue is full.
+bool spsc_queue_push(SpscQueue *q, void *item) {
+  size_t tail = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+  size_t head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+  if (tail - head == q->capacity) {
+    return false;
+  }
+  q->items[tail & (q->capacity - 1)] = item;
+  __atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+// Consumer only. NULL if the queue is empty.
+void *spsc_queue_pop(SpscQueue *q) {
+  size_t head = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+  size_t tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+  if (head == tail) {
+    return NULL;
+  }
+  void *item = q->items[head & (q->capacity - 1)];
+  __atomic_store_n(&q->head, head + 1, __ATOMIC_RELEASE);
+  return item;
+}
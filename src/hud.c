@@ -0,0 +1,109 @@
+//
+// Retained HUD
+//
+// The clock only moves once per in-game minute and the inventory almost
+// never, so each HUD line remembers the value its text was formatted from
+// and is only re-formatted when that value changes. The lines are
+// composited into one RenderTexture which is redrawn only when a line or
+// the energy bar changed - on every other frame the whole HUD is one quad.
+//
+
+#define HUD_WIDTH 300
+#define HUD_LINE_LENGTH 64
+
+typedef struct HudLine {
+  bool valid;
+  int key; // the value the text was last formatted from
+  char text[HUD_LINE_LENGTH];
+} HudLine;
+
+typedef struct Hud {
+  RenderTexture2D target;
+  Atlas *atlas;
+  char *title;
+  HudLine clock; // key is the total minutes played
+  HudLine inventory[MAX_INVENTORY_COUNT];
+  int energyHeight;
+  bool energyLow;
+  bool dirty; // target needs redrawing
+} Hud;
+
+const int hudFontY = 10;
+const int hudFontSize = 40;
+
+void InitHud(Hud *hud, Atlas *atlas, char *title, int screenHeight) {
+  memset(hud, 0, sizeof(*hud));
+  hud->atlas = atlas;
+  hud->title = title;
+  hud->target = LoadRenderTexture(HUD_WIDTH, screenHeight);
+  hud->dirty = true;
+}
+
+void UnloadHud(Hud *hud) { UnloadRenderTexture(hud->target); }
+
+// Returns true if the line needs re-formatting
+bool HudLineChanged(HudLine *line, int key) {
+  if (line->valid && line->key == key) {
+    return false;
+  }
+  line->valid = true;
+  line->key = key;
+  return true;
+}
+
+void UpdateHud(Hud *hud, World *world) {
+  int totalMinutes = world->dayCount * 60 * 24 + world->timeInMinutes;
+  if (HudLineChanged(&hud->clock, totalMinutes)) {
+    snprintf(hud->clock.text, HUD_LINE_LENGTH, "Day %d, %02d:%02d",
+             world->dayCount + 1, world->timeInMinutes / 60,
+             world->timeInMinutes % 60);
+    hud->dirty = true;
+  }
+
+  for (int i = 0; i < MAX_INVENTORY_COUNT; i++) {
+    HudLine *line = &hud->inventory[i];
+    if (HudLineChanged(line, world->inventory[i])) {
+      snprintf(line->text, HUD_LINE_LENGTH, "%s: %d", getArchetypeName(i),
+               world->inventory[i]);
+      hud->dirty = true;
+    }
+  }
+
+  int energyHeight = world->energy * 5;
+  bool energyLow = world->energy <= 30;
+  if (energyHeight != hud->energyHeight || energyLow != hud->energyLow) {
+    hud->energyHeight = energyHeight;
+    hud->energyLow = energyLow;
+    hud->dirty = true;
+  }
+
+  if (!hud->dirty) {
+    return;
+  }
+
+  // Must happen outside BeginDrawing/EndDrawing
+  BeginTextureMode(hud->target);
+  ClearBackground(BLANK);
+  DrawAtlasText(hud->atlas, hud->title, 0, hudFontY, hudFontSize, RED);
+  DrawAtlasText(hud->atlas, hud->clock.text, 0, hudFontY + 30, hudFontSize,
+                BLACK);
+  DrawAtlasText(hud->atlas, "Inventory:", 0, hudFontY + 50, hudFontSize, RED);
+  for (int i = 0; i < MAX_INVENTORY_COUNT; i++) {
+    if (hud->inventory[i].key > 0) {
+      DrawAtlasText(hud->atlas, hud->inventory[i].text, 0,
+                    hudFontY + 30 * (i + 2), hudFontSize, RED);
+    }
+  }
+  DrawRectangle(0, hudFontY + 200, 50, hud->energyHeight,
+                hud->energyLow ? RED : GREEN);
+  EndTextureMode();
+  hud->dirty = false;
+}
+
+void DrawHud(Hud *hud, int x, int y) {
+  // Render textures are stored upside down
+  Texture2D texture = hud->target.texture;
+  DrawTextureRec(texture,
+                 (Rectangle){0, 0, texture.width, -(float)texture.height},
+                 (Vector2){x, y}, WHITE);
+}
@@ -2,458 +2,178 @@
 #include "raymath.h"
 #include "rlgl.h"
 #include <math.h>
-
-#define assert(cond, ...)                                                      \
-  { assert_line(__LINE__, cond, __VA_ARGS__) }
-#if CONFIGURATION == RELEASE
-#undef assert
-#define assert(x, ...) (void)(x)
-#endif
-
-// Memory Sizes
-#define KB(x) (x * 1024ull)
-#define MB(x) ((KB(x)) * 1024ull)
-#define GB(x) ((MB(x)) * 1024ull)
-
-//
-
-#include <stddef.h>
-#include <stdint.h>
-
-#if !defined(__cplusplus)
-#if (defined(_MSC_VER) && _MSC_VER < 1800) ||                                  \
-    (!defined(_MSC_VER) && !defined(__STDC_VERSION__))
-#ifndef true
-#define true (0 == 0)
-#endif
-#ifndef false
-#define false (0 != 0)
-#endif
-typedef unsigned char bool;
-#else
-#include <stdbool.h>
-#endif
-#endif
-
-#include <stdio.h>
+#include <pthread.h>
 #include <stdlib.h>
-#include <string.h>
-
-bool is_power_of_two(uintptr_t x) { return (x & (x - 1)) == 0; }
-
-uintptr_t align_forward(uintptr_t ptr, size_t align) {
-  uintptr_t p, a, modulo;
-
-  assert(is_power_of_two(align));
+#include <time.h>
+
+// Unity build - the makefile only compiles this file
+#include "arena.c"
+#include "pool.c"
+#include "atomic_arena.c"
+#include "containers.c"
+#include "string_builder.c"
+#include "compress.c"
+#include "noise.c"
+#include "world.c"
+#include "animation.c"
+#include "tilemap.c"
+#include "worldgen.c"
+#include "streaming.c"
+#include "save.c"
+#include "autosave.c"
+#include "rewind.c"
+#include "atlas.c"
+#include "hud.c"
+#include "render.c"
 
-  p = ptr;
-  a = (uintptr_t)align;
-  // Same as (p % a) but faster as 'a' is a power of two
-  modulo = p & (a - 1);
+void UpdateStartState(World *world);
+void UpdatePlayState(World *world, GameMemory *memory);
+/* void UpdatePauseState(World *world); */
+void UpdateGameOverState(World *world, GameMemory *memory);
+void UpdateState(World *world, GameMemory *memory) {
+  BeginFrameMemory(memory);
 
-  if (modulo != 0) {
-    // If 'p' address is not aligned, push the address to the
-    // next value which is aligned
-    p += a - modulo;
+  switch (world->state) {
+  case state_start:
+    return UpdateStartState(world);
+  case state_play:
+    return UpdatePlayState(world, memory);
+  case state_gameover:
+    return UpdateGameOverState(world, memory);
+  default:
+    return;
   }
-  return p;
-}
-
-#ifndef DEFAULT_ALIGNMENT
-#define DEFAULT_ALIGNMENT (2 * sizeof(void *))
-#endif
-
-//
-float sin_breathe(float time, float rate) {
-  return (sin(time * rate) + 1.0) / 2.0;
-}
-//
-
-typedef struct Arena Arena;
-struct Arena {
-  unsigned char *buf;
-  size_t buf_len;
-  size_t prev_offset; // This will be useful for later on
-  size_t curr_offset;
 };
 
-void arena_init(Arena *a, void *backing_buffer, size_t backing_buffer_length) {
-  a->buf = (unsigned char *)backing_buffer;
-  a->buf_len = backing_buffer_length;
-  a->curr_offset = 0;
-  a->prev_offset = 0;
+static char gameTitle[16] = "Farm To Table";
+static bool showArenaOverlay = false; // toggled with F3
+static Atlas atlas;
+static Hud hud;
+static LowResTarget lowRes; // toggled with F4
+static ChunkCache chunkCache; // toggled with F6
+static GroundLayer ground;     // F7 switches to the fallback
+static Streamer streamer;
+static Autosaver autosaver;
+static Rewind history; // F12 records, F11 scrubs through it
+
+// A new world every game unless WORLD_SEED is set. The seed is printed so a
+// map can be played again.
+uint32_t NewWorldSeed(void) {
+  char *fixed = getenv("WORLD_SEED");
+  uint32_t seed = fixed ? (uint32_t)strtoul(fixed, NULL, 10)
+                        : hash_u64((uint64_t)time(NULL));
+  printf("world seed: %u\n", seed);
+  return seed;
 }
 
-void *arena_alloc_align(Arena *a, size_t size, size_t align) {
-  // Align 'curr_offset' forward to the specified alignment
-  uintptr_t curr_ptr = (uintptr_t)a->buf + (uintptr_t)a->curr_offset;
-  uintptr_t offset = align_forward(curr_ptr, align);
-  offset -= (uintptr_t)a->buf; // Change to relative offset
-
-  // Check to see if the backing memory has space left
-  if (offset + size <= a->buf_len) {
-    void *ptr = &a->buf[offset];
-    a->prev_offset = offset;
-    a->curr_offset = offset + size;
-
-    // Zero new memory by default
-    memset(ptr, 0, size);
-    return ptr;
+// StartSession plus everything outside the World that follows it
+World *NewGame(GameMemory *memory) {
+  World *next = StartSession(memory, NewWorldSeed());
+  if (next) {
+    ResetStreamer(&streamer, next);
+    ResetAutosaver(&autosaver, next);
+    ResetRewind(&history);
+    ReleaseLoadedSave(); // the World no longer lives in it
   }
-  // Return NULL if the arena is out of memory (or handle differently)
-  return NULL;
-}
-
-// Because C doesn't have default parameters
-void *arena_alloc(Arena *a, size_t size) {
-  return arena_alloc_align(a, size, DEFAULT_ALIGNMENT);
-}
-
-void arena_free(Arena *a, void *ptr) {
-  // Do nothing
+  return next;
 }
 
-void *arena_resize_align(Arena *a, void *old_memory, size_t old_size,
-                         size_t new_size, size_t align) {
-  unsigned char *old_mem = (unsigned char *)old_memory;
-
-  assert(is_power_of_two(align));
-
-  if (old_mem == NULL || old_size == 0) {
-    return arena_alloc_align(a, new_size, align);
-  } else if (a->buf <= old_mem && old_mem < a->buf + a->buf_len) {
-    if (a->buf + a->prev_offset == old_mem) {
-      a->curr_offset = a->prev_offset + new_size;
-      if (new_size > old_size) {
-        // Zero the new memory by default
-        memset(&a->buf[a->curr_offset], 0, new_size - old_size);
-      }
-      return old_memory;
-    } else {
-      void *new_memory = arena_alloc_align(a, new_size, align);
-      size_t copy_size = old_size < new_size ? old_size : new_size;
-      // Copy across old memory to the new memory
-      memmove(new_memory, old_memory, copy_size);
-      return new_memory;
-    }
-
-  } else {
-    assert(0 && "Memory is out of bounds of the buffer in this arena");
-    return NULL;
+// Everything outside the World that follows LoadGame or LoadAutosave
+World *ContinueGame(World *next) {
+  if (next) {
+    ResetStreamer(&streamer, next);
+    ResetAutosaver(&autosaver, next);
+    ResetRewind(&history);
+    next->state = state_play;
   }
+  return next;
 }
 
-// Because C doesn't have default parameters
-void *arena_resize(Arena *a, void *old_memory, size_t old_size,
-                   size_t new_size) {
-  return arena_resize_align(a, old_memory, old_size, new_size,
-                            DEFAULT_ALIGNMENT);
-}
-
-void arena_free_all(Arena *a) {
-  a->curr_offset = 0;
-  a->prev_offset = 0;
-}
-
-// Extra Features
-typedef struct Temp_Arena_Memory Temp_Arena_Memory;
-struct Temp_Arena_Memory {
-  Arena *arena;
-  size_t prev_offset;
-  size_t curr_offset;
-};
-
-Temp_Arena_Memory temp_arena_memory_begin(Arena *a) {
-  Temp_Arena_Memory temp;
-  temp.arena = a;
-  temp.prev_offset = a->prev_offset;
-  temp.curr_offset = a->curr_offset;
-  return temp;
-}
-
-void temp_arena_memory_end(Temp_Arena_Memory temp) {
-  temp.arena->prev_offset = temp.prev_offset;
-  temp.arena->curr_offset = temp.curr_offset;
+// Horizontally centred on the screen
+void DrawCenteredText(World *world, const char *text, int y, int size,
+                      Color color) {
+  int x = world->screenWidth / 2 - MeasureAtlasText(&atlas, text, size) / 2;
+  DrawAtlasText(&atlas, text, x, y, size, color);
 }
 
-//
-// Game Code
-//
-
-typedef enum EntityArchetype {
-  arch_nil = 0,
-  arch_player,
-  arch_hoe,
-  arch_shovel,
-  arch_weed,
-  arch_rock,
-  arch_item_wood,
-  arch_item_plant_matter,
-  arch_item_stone,
-  ARCH_MAX
-} EntityArchetype;
-char *getArchetypeName(EntityArchetype arch) {
-  switch (arch) {
-  case arch_player:
-    return "player";
-  case arch_hoe:
-    return "hoe";
-  case arch_shovel:
-    return "shovel";
-  case arch_weed:
-    return "weed";
-  case arch_rock:
-    return "rock";
-  case arch_item_wood:
-    return "item wood";
-  case arch_item_stone:
-    return "item stone";
-  case arch_item_plant_matter:
-    return "item plant matter";
-  default:
-    return "nil";
+// Returns the y below the last line drawn. Text is formatted into textArena.
+int DrawArenaOverlay(Arena *textArena, Arena *arena, int x, int y) {
+  const int fontSize = 20;
+  char *line = arena_printf_tagged(
+      textArena, arena_tag_hud, "%s: used %zu KB, high water %zu, committed %zu",
+      arena->name, arena->curr_offset / 1024, arena->stats.high_water / 1024,
+      arena->committed / 1024);
+  if (line) {
+    DrawAtlasText(&atlas, line, x, y, fontSize, RAYWHITE);
   }
-};
-
-typedef enum SpriteId {
-  sprite_nil = 0,
-  sprite_player,
-  sprite_hoe,
-  sprite_shovel,
-  sprite_weed,
-  sprite_rock,
-  sprite_wood,
-  sprite_stone_material,
-  sprite_plant_material,
-  SPRITE_MAX
-} SpriteId;
-
-SpriteId getArchetypeSpriteId(EntityArchetype arch) {
-  switch (arch) {
-  case arch_player:
-    return sprite_player;
-  case arch_hoe:
-    return sprite_hoe;
-  case arch_shovel:
-    return sprite_shovel;
-  case arch_weed:
-    return sprite_weed;
-  case arch_rock:
-    return sprite_rock;
-  case arch_item_wood:
-    return sprite_wood;
-  case arch_item_stone:
-    return sprite_stone_material;
-  case arch_item_plant_matter:
-    return sprite_plant_material;
-  default:
-    return sprite_nil;
-  }
-};
-
-Texture2D sprites[SPRITE_MAX];
-Texture2D *get_sprite(SpriteId id) {
-  if (id >= 0 && id < SPRITE_MAX) {
-    return &sprites[id];
+  y += fontSize;
+  for (int i = 0; i < ARENA_TAG_MAX; i++) {
+    if (!arena->stats.tag_allocs[i]) {
+      continue;
+    }
+    line = arena_printf_tagged(textArena, arena_tag_hud,
+                               "  %-10s %10zu B %8zu allocs", arenaTagNames[i],
+                               arena->stats.tag_bytes[i],
+                               arena->stats.tag_allocs[i]);
+    if (line) {
+      DrawAtlasText(&atlas, line, x, y, fontSize, RAYWHITE);
+    }
+    y += fontSize;
   }
-  return &sprites[0];
-}
-
-typedef struct Entity {
-  EntityArchetype archetype;
-  Vector2 pos;
-  bool is_valid;
-  int health;
-  SpriteId sprite_id;
-  bool is_item;
-  bool is_destroyable_world_item;
-} Entity;
-
-typedef enum GameState {
-  state_nil = 0,
-  state_start,
-  state_pause,
-  state_play,
-  state_gameover,
-  STATE_MAX
-} GameState;
-
-#define MAX_ENTITY_COUNT 1024
-#define MAX_INVENTORY_COUNT ARCH_MAX
-typedef struct World {
-  Entity entities[MAX_ENTITY_COUNT];
-  int inventory[MAX_INVENTORY_COUNT];
-  int timeInMinutes;
-  double timeElapsed;
-  int dayCount;
-  float energy;
-  float hydration;
-  GameState state;
-  float screenHeight;
-  float screenWidth;
-  Entity *player;
-  Color backgroundColor;
-  Camera2D camera;
-} World;
-
-World *world = 0;
-
-Entity *entity_create() {
-  Entity *entity_found = 0;
-  for (int i = 0; i < MAX_ENTITY_COUNT; i++) {
-    Entity *existing_entity = &(world->entities[i]);
-    if (!existing_entity->is_valid) {
-      entity_found = existing_entity;
-      break;
+  if (arena->stats.overflow_count) {
+    line = arena_printf_tagged(textArena, arena_tag_hud, "  overflows %zu",
+                               arena->stats.overflow_count);
+    if (line) {
+      DrawAtlasText(&atlas, line, x, y, fontSize, RED);
     }
+    y += fontSize;
   }
-  assert(entity_found, "No more free entities!");
-
-  memset(entity_found, 0, sizeof(Entity));
-
-  entity_found->is_valid = true;
-  return entity_found;
-}
-
-const float tileWidth = 40;
-
-int world_pos_to_tile_pos(float world_pos) {
-  return roundf(world_pos / tileWidth);
+  return y;
 }
 
-float tile_pos_to_world_pos(int tile_pos) { return tileWidth * tile_pos; }
-
-Vector2 round_v2_to_tile(Vector2 v2) {
-  v2.x = tile_pos_to_world_pos(world_pos_to_tile_pos(v2.x));
-  v2.y = tile_pos_to_world_pos(world_pos_to_tile_pos(v2.y));
-  return v2;
-}
-
-const int playerHealth = 5;
-const float playerPickupRadius = 20.0;
-const int rockHealth = 3;
-const int weedHealth = 2;
-
-Entity *SetupPlayer(Vector2 pos) {
-  Entity *entity = entity_create();
-
-  entity->pos = round_v2_to_tile(pos);
-  entity->pos.y -= tileWidth * 0.5;
-  entity->health = playerHealth;
-  /* entity->pos.x -= tileWidth * 0.5; */
-
-  entity->archetype = arch_player;
-  entity->sprite_id = sprite_player;
-  return entity;
-}
-Camera2D SetupCamera(Vector2 initialPlayerPosition) {
-  Camera2D camera = {0};
-
-  camera.target = world->player->pos;
-  camera.offset =
-      (Vector2){world->screenWidth / 2.0f, world->screenHeight / 2.0f};
-  camera.rotation = 0.0f;
-  camera.zoom = 1.25f;
-
-  return camera;
-}
-
-void SetupRock(Vector2 pos) {
-  Entity *entity = entity_create();
-
-  entity->pos = round_v2_to_tile(pos);
-  entity->pos.y -= tileWidth * 0.5;
-  /* entity->pos.x += tileWidth * 0.125; */
-  entity->health = rockHealth;
-  entity->is_destroyable_world_item = true;
-
-  entity->archetype = arch_rock;
-  entity->sprite_id = sprite_rock;
-}
-
-void SetupWeed(Vector2 pos) {
-  Entity *entity = entity_create();
-
-  entity->pos = round_v2_to_tile(pos);
-  entity->pos.y -= tileWidth * 0.5;
-  entity->pos.x += tileWidth * 0.25;
-  entity->health = weedHealth;
-  entity->is_destroyable_world_item = true;
-
-  entity->archetype = arch_weed;
-  entity->sprite_id = sprite_weed;
-}
-
-void SetupItemWood(Vector2 pos) {
-  Entity *entity = entity_create();
-
-  entity->pos = round_v2_to_tile(pos);
-  entity->pos.y -= tileWidth * 0.5;
-  entity->pos.x += tileWidth * 0.5;
-
-  entity->is_item = true;
-
-  entity->archetype = arch_item_wood;
-  entity->sprite_id = sprite_wood;
-}
-
-Vector2 v2(float x, float y) { return (Vector2){x, y}; }
-
-void UpdateCameraCenterSmoothFollow(Camera2D *camera, Entity *player,
-                                    float delta, int width, int height) {
-  static float minSpeed = 30;
-  static float minEffectLength = 5;
-  static float fractionSpeed = 0.9f;
-
-  camera->offset = (Vector2){width / 2.0f, height / 2.0f};
-  Vector2 diff = Vector2Subtract(player->pos, camera->target);
-  float length = Vector2Length(diff);
-
-  if (length > minEffectLength) {
-    float speed = fmaxf(fractionSpeed * length, minSpeed);
-    camera->target =
-        Vector2Add(camera->target, Vector2Scale(diff, speed * delta / length));
+void DrawMemoryOverlay(GameMemory *memory, int x, int y) {
+  Arena *frameArena = FrameArena(memory);
+  DrawRectangle(x - 5, y - 5, 520, 340, Fade(BLACK, 0.6f));
+  y = DrawArenaOverlay(frameArena, &memory->permanent, x, y);
+  y = DrawArenaOverlay(frameArena, &memory->session, x, y);
+  y = DrawArenaOverlay(frameArena, frameArena, x, y);
+  char *line = arena_printf_tagged(
+      frameArena, arena_tag_hud, "chunks: %d loaded, %d in flight, %.2f ms",
+      streamer.loaded, streamer.inFlight, streamer.integrateNs / 1e6);
+  if (line) {
+    DrawAtlasText(&atlas, line, x, y, 20, RAYWHITE);
+    y += 20;
   }
-}
-
-void InitWorld(World *world) {
-  world->state = state_start;
-  world->dayCount = 0;
-  world->timeElapsed = 0;
-  world->timeInMinutes = 720; // 12noon
-  world->energy = 100;
-  world->hydration = 100;
-  world->screenWidth = 1280;
-  world->screenHeight = 720;
-  world->backgroundColor = GetColor(0x4b692fff);
-
-  Vector2 initialPlayerPosition = {world->screenWidth / 2.0f,
-                                   world->screenHeight / 2.0f};
-  world->player = SetupPlayer(initialPlayerPosition);
-  world->camera = SetupCamera(initialPlayerPosition);
-};
-
-#define ARENA_SIZE MB(20)
-/* static unsigned char backing_buffer[ARENA_SIZE]; */
-
-void UpdateStartState(World *world);
-void UpdatePlayState(World *world, Arena *arena);
-/* void UpdatePauseState(World *world); */
-void UpdateGameOverState(World *world, Arena *arena);
-void UpdateState(World *world, Arena *arena) {
-  switch (world->state) {
-  case state_start:
-    return UpdateStartState(world);
-  case state_play:
-    return UpdatePlayState(world, arena);
-  case state_gameover:
-    return UpdateGameOverState(world, arena);
-  default:
-    return;
+  line = NULL;
+  if (autosaver.mode == autosave_fork) {
+    line = arena_printf_tagged(
+        frameArena, arena_tag_hud,
+        "autosave (fork): %.2f ms paused, %.1f ms writing",
+        autosaver.forkPauseNs / 1e6, autosaver.forkNs / 1e6);
+  } else if (!AutosaveBusy(&autosaver)) {
+    line = arena_printf_tagged(
+        frameArena, arena_tag_hud,
+        "autosave (chunks): %d chunks, %.2f ms staging, %.1f ms writing",
+        autosaver.stagedChunks, autosaver.stageNs / 1e6,
+        autosaver.writeNs / 1e6);
   }
-};
-
-static char gameTitle[16] = "Farm To Table";
+  if (line) {
+    DrawAtlasText(&atlas, line, x, y, 20, RAYWHITE);
+    y += 20;
+  }
+  uint64_t frames = history.next - history.oldest;
+  line = history.recording
+             ? arena_printf_tagged(
+                   frameArena, arena_tag_hud,
+                   "rewind: %.1f s, %.0f KB (%.0f KB packed), %.2f ms capture",
+                   frames / 60.0, history.bytesUsed / 1024.0,
+                   history.rawBytes / 1024.0, history.captureNs / 1e6)
+             : "rewind: off (F12 records)";
+  if (line) {
+    DrawAtlasText(&atlas, line, x, y, 20,
+                  history.scrubbing ? YELLOW : RAYWHITE);
+  }
+}
 
 //------------------------------------------------------------------------------------
 // Program main entry point
@@ -462,54 +182,55 @@ int main(void) {
   // Initialization
   //--------------------------------------------------------------------------------------
 
-  void *backing_buffer = malloc(ARENA_SIZE);
-  Arena arena = {0};
-  arena_init(&arena, backing_buffer, ARENA_SIZE);
-  world = arena_alloc(&arena, sizeof(World));
-  /* printf("FIRST ARENA ALLOC: current offset - %lu, previous offset - %lu, "
-   */
-  /*        "Arena Size - %llu", */
-  /*        a.curr_offset, a.prev_offset, ARENA_SIZE); */
-  InitWorld(world);
+  static GameMemory memory;
+  if (!InitGameMemory(&memory)) {
+    fprintf(stderr, "could not reserve address space for the arenas\n");
+    return 1;
+  }
+  if (!InitStreamer(&streamer, &memory.permanent) ||
+      !InitAutosaver(&autosaver, &memory.permanent, AUTOSAVE_DIR) ||
+      !InitRewind(&history, &memory.permanent) ||
+      !NewGame(&memory)) {
+    return 1;
+  }
 
   InitWindow(world->screenWidth, world->screenHeight, gameTitle);
 
   SetTargetFPS(60); // Set our game to run at 60 frames-per-second
 
-  sprites[sprite_nil] = LoadTexture("assets/sprites/nil_texture.png");
-
-  sprites[sprite_player] = LoadTexture("assets/sprites/player.png");
-  sprites[sprite_weed] = LoadTexture("assets/sprites/weed.png");
-  sprites[sprite_rock] = LoadTexture("assets/sprites/rock.png");
-
-  sprites[sprite_shovel] = LoadTexture("assets/sprites/shovel.png");
-  sprites[sprite_hoe] = LoadTexture("assets/sprites/hoe.png");
-
-  sprites[sprite_wood] = LoadTexture("assets/sprites/wood.png");
-  sprites[sprite_stone_material] =
-      LoadTexture("assets/sprites/stone_material.png");
-  sprites[sprite_plant_material] =
-      LoadTexture("assets/sprites/plant_material.png");
-
-  for (int i = 0; i < 10; i++) {
-    SetupRock(v2(i * 100, i * 100));
-  }
-  for (int i = 0; i < 10; i++) {
-    SetupWeed(v2(i * 150, i * 322));
+  if (!BuildAtlas(&atlas, &memory.permanent)) {
+    CloseWindow();
+    return 1;
   }
+  InitHud(&hud, &atlas, gameTitle, world->screenHeight);
+  InitChunkCache(&chunkCache, &atlas);
+  InitGroundLayer(&ground, &atlas);
+  InitLowResTarget(&lowRes, world->screenWidth, world->screenHeight,
+                   world->camera.zoom);
 
   //--------------------------------------------------------------------------------------
   // Main game loop
   while (!WindowShouldClose()) // Detect window close button or ESC key
   {
-    UpdateState(world, &arena);
+    UpdateState(world, &memory);
   }
   //--------------------------------------------------------------------------------------
 
   // De-Initialization
   //--------------------------------------------------------------------------------------
+  UnloadStreamer(&streamer);
+  UnloadAutosaver(&autosaver);
+  UnloadLowResTarget(&lowRes);
+  UnloadChunkCache(&chunkCache);
+  UnloadGroundLayer(&ground);
+  UnloadHud(&hud);
+  UnloadAtlas(&atlas);
   CloseWindow(); // Close window and OpenGL context
-  free(backing_buffer);
+  arena_print_report(&memory.permanent, stdout);
+  arena_print_report(&memory.session, stdout);
+  arena_print_report(&memory.frame[0], stdout);
+  arena_print_report(&memory.frame[1], stdout);
+  ReleaseGameMemory(&memory);
   //--------------------------------------------------------------------------------------
 
   return 0;
@@ -524,57 +245,144 @@ void UpdateStartState(World *world) {
 
   ClearBackground(world->backgroundColor);
   Vector2 center = {world->screenWidth / 2.0f, world->screenHeight / 2.0f};
-  DrawText(gameTitle, center.x, center.y, 24, BLACK);
-
-  char click[16] = "Click To Start";
-  DrawText(click, center.x, center.y + 20, 24, BLACK);
+  DrawCenteredText(world, gameTitle, center.y, 24, BLACK);
+  DrawCenteredText(world, "Click To Start", center.y + 20, 24, BLACK);
 
   EndDrawing();
 }
 
-void UpdateGameOverState(World *world, Arena *arena) {
+void UpdateGameOverState(World *world, GameMemory *memory) {
+  if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+    // StartSession replaces the global world - the parameter is stale after
+    World *next = NewGame(memory);
+    if (next) {
+      next->state = state_play;
+    }
+    return;
+  }
+
+  Arena *frameArena = FrameArena(memory);
   BeginDrawing();
 
   ClearBackground(world->backgroundColor);
   Vector2 center = {world->screenWidth / 2.0f, world->screenHeight / 2.0f};
-  DrawText(gameTitle, center.x, center.y, 24, BLACK);
-
-  Temp_Arena_Memory tmp = temp_arena_memory_begin(arena);
-  char *resultsStr = arena_alloc(arena, 128);
-  sprintf(resultsStr, "You Survived %d days, %02d hours, and %02d minutes",
-          world->dayCount + 1, world->timeInMinutes / 60,
-          world->timeInMinutes % 60);
-  DrawText(resultsStr, center.x, center.y + 20, 24, BLACK);
-  temp_arena_memory_end(tmp);
+  DrawCenteredText(world, gameTitle, center.y, 24, BLACK);
+
+  int days = world->dayCount + 1;
+  int hours = world->timeInMinutes / 60;
+  int minutes = world->timeInMinutes % 60;
+  StringBuilder results;
+  if (sb_init(&results, frameArena, arena_tag_hud, 64)) {
+    sb_appendf(&results, "You Survived %d day%s", days, days == 1 ? "" : "s");
+    sb_appendf(&results, ", %02d hour%s", hours, hours == 1 ? "" : "s");
+    sb_appendf(&results, ", and %02d minute%s", minutes,
+               minutes == 1 ? "" : "s");
+    DrawCenteredText(world, results.data, center.y + 20, 24, BLACK);
+  }
 
-  char click[32] = "TODO: Click To Play Again";
-  DrawText(click, center.x, center.y + 40, 24, BLACK);
+  DrawCenteredText(world, "Click To Play Again", center.y + 40, 24, BLACK);
 
   EndDrawing();
 };
 
-void UpdatePlayState(World *world, Arena *arena) {
+// Everything in world space - call inside a 2D camera mode
+void DrawWorld(World *world, Rectangle mouseRectangle) {
+  DrawGroundLayer(&ground, world);
+
+  // TODO: maybe this isn't the right way to approach this
+  // Draw the 3d grid, rotated 90 degrees and centered around 0,0
+  // just so we have something in the XY plane
+  rlPushMatrix();
+  rlTranslatef(0, 25 * tileWidth, 0);
+  rlRotatef(90, 1, 0, 0);
+  // I think the 1000 here is how many tiles
+  DrawGrid(1000, tileWidth);
+  rlPopMatrix();
+
+  DrawRectangleRec(mouseRectangle, RED);
+
+  if (chunkCache.enabled) {
+    DrawChunkCache(&chunkCache);
+  }
+
+  // a tile of margin for bobbing items
+  Rectangle view = GetCameraView(world);
+  view = (Rectangle){view.x - tileWidth, view.y - tileWidth,
+                     view.width + 2 * tileWidth, view.height + 2 * tileWidth};
+
+  for (int i = 0; i < world->entityHighWater; i++) {
+    Entity *existing_entity = &world->entities[i];
+    if (existing_entity && existing_entity->is_valid) {
+      if (chunkCache.enabled && entity_is_static(existing_entity)) {
+        continue; // already in its chunk's texture
+      }
+      if (!rect_overlaps(view, GetEntityBounds(existing_entity))) {
+        continue;
+      }
+
+      /* Debug Rectangles  */
+      /* DrawRectangleRec(GetEntityBounds(existing_entity), RAYWHITE); */
+
+      // make collectibles bounce - see UpdateAnimation
+      Vector2 translation = v2(0, world->bobOffset[i]);
+
+      int frame = world->animClip[i] ? world->animFrame[i]
+                                     : (int)existing_entity->sprite_id;
+      DrawFrame(&atlas, frame, Vector2Add(existing_entity->pos, translation),
+                spriteScale, RAYWHITE);
+
+      // DEBUG - print all entities' positions below them
+      /* char posStr[100]; */
+      /* sprintf(posStr, "(%.2f, %.2f)", existing_entity->pos.x, */
+      /*         existing_entity->pos.y); */
+      /* DrawText(posStr, existing_entity->pos.x, existing_entity->pos.y +
+       * 30,
+       */
+      /*          20, RED); */
+    }
+  }
+}
+
+void UpdatePlayState(World *world, GameMemory *memory) {
   const float deltaT = GetFrameTime();
-  const float playerSpeed = 300;
-  const float defaultFatigueRate = 1;
 
-  if (world->energy <= 0) {
+  // While scrubbing the World is a past frame and nothing is simulated -
+  // the arrow keys step through time instead of moving the player
+  if (IsKeyPressed(KEY_F11)) {
+    if (history.scrubbing) {
+      EndRewind(&history);
+      ResetStreamer(&streamer, world); // the chunks' data wasn't kept
+      ResetAutosaver(&autosaver, world);
+    } else {
+      BeginRewind(&history, world);
+    }
+  }
+  if (!history.scrubbing && IsKeyPressed(KEY_F12)) {
+    SetRewindRecording(&history, !history.recording);
+  }
+  if (history.scrubbing) {
+    ScrubRewind(&history, world, IsKeyDown(KEY_RIGHT) - IsKeyDown(KEY_LEFT));
+  } else if (!UpdateClock(world, deltaT)) {
     world->state = state_gameover;
     return;
   }
 
-  // TODO: maybe make the clock only update every 5 or ten minutes like in
-  // SDV 1 seconds = 1 minute, 24 minutes in game is a 24 hour day
-  const float deltaTScale = 1;
-  world->timeElapsed += deltaT;
-  if (world->timeElapsed >= deltaTScale) {
-    world->timeElapsed = 0;
-    world->timeInMinutes += 1;
-    world->energy -= defaultFatigueRate;
+  if (!history.scrubbing && IsKeyPressed(KEY_F5)) {
+    ReapAutosaveChild(&autosaver, true); // one save at a time
+    if (!SaveGame(world, FrameArena(memory), SAVE_PATH)) {
+      fprintf(stderr, "save: couldn't write %s\n", SAVE_PATH);
+    }
   }
-  if (world->timeInMinutes >= (60 * 24)) {
-    world->dayCount += 1;
-    world->timeInMinutes = 0;
+  if (!history.scrubbing && IsKeyPressed(KEY_F8) &&
+      ContinueGame(autosaver.mode == autosave_fork
+                       ? LoadGame(memory, AUTOSAVE_FORK_PATH)
+                       : LoadAutosave(memory, AUTOSAVE_DIR))) {
+    // loading replaces the global world - the parameter is stale after
+    return;
+  }
+  if (!history.scrubbing && IsKeyPressed(KEY_F9) &&
+      ContinueGame(LoadGame(memory, SAVE_PATH))) {
+    return;
   }
 
   // Update
@@ -589,12 +397,11 @@ void UpdatePlayState(World *world, Arena *arena) {
   if (IsKeyDown(KEY_DOWN))
     movement.y += 1;
 
-  movement = Vector2Normalize(movement);
-  movement = Vector2Scale(movement, deltaT * playerSpeed);
-
-  world->player->pos = Vector2Add(world->player->pos, movement);
-  UpdateCameraCenterSmoothFollow(&world->camera, world->player, deltaT,
-                                 world->screenWidth, world->screenHeight);
+  if (!history.scrubbing) {
+    UpdatePlayerMovement(world, movement, deltaT);
+    UpdateCameraCenterSmoothFollow(&world->camera, world->player, deltaT,
+                                   world->screenWidth, world->screenHeight);
+  }
 
   Vector2 mouseScreenPosition = GetMousePosition();
   Vector2 mouseWorldPosition =
@@ -602,134 +409,71 @@ void UpdatePlayState(World *world, Arena *arena) {
   // NOTE: alignment didnt feel right before - this slight adjustment fixes
   mouseWorldPosition = Vector2Subtract(mouseWorldPosition, v2(10, 10));
   Vector2 mouseTilePosition = round_v2_to_tile(mouseWorldPosition);
-
-  const float scale = 4.0;
-
-  //----------------------------------------------------------------------------------
-
-  // Draw
-  //----------------------------------------------------------------------------------
-  BeginDrawing();
-
-  ClearBackground(world->backgroundColor);
-
-  BeginMode2D(world->camera);
-
-  // TODO: maybe this isn't the right way to approach this
-  // Draw the 3d grid, rotated 90 degrees and centered around 0,0
-  // just so we have something in the XY plane
-  rlPushMatrix();
-  rlTranslatef(0, 25 * tileWidth, 0);
-  rlRotatef(90, 1, 0, 0);
-  // I think the 1000 here is how many tiles
-  DrawGrid(1000, tileWidth);
-  rlPopMatrix();
-
   Rectangle mouseRectangle = (Rectangle){
       mouseTilePosition.x, mouseTilePosition.y, tileWidth, tileWidth};
-  DrawRectangleRec(mouseRectangle, RED);
 
-  for (int i = 0; i < MAX_ENTITY_COUNT; i++) {
-    Entity *existing_entity = &world->entities[i];
-    if (existing_entity && existing_entity->is_valid) {
-      Texture2D sprite = sprites[existing_entity->sprite_id];
-
-      Rectangle entityBounds = {existing_entity->pos.x, existing_entity->pos.y,
-                                sprite.width * scale, sprite.height * scale};
-
-      // Check if point is inside rectangle
-      // TODO: instead - check if the mouse tile is the same as the entity's
-      // tile
-      bool mouseInBounds = CheckCollisionRecs(mouseRectangle, entityBounds);
+  if (!history.scrubbing) {
+    UpdateStreaming(&streamer, world, deltaT);
+    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+      UpdateHarvest(world, mouseRectangle);
+    }
+    UpdatePickup(world);
+    UpdateAutosave(&autosaver, world, deltaT);
+    UpdateAnimation(world, GetTime());
+    UpdateSpriteAnimation(world, deltaT);
+    CaptureRewind(&history, world);
+  }
 
-      /* Color col = RAYWHITE; */
-      /* if (mouseInBounds) { */
-      /*   col = RED; */
-      /* } */
+  if (IsKeyPressed(KEY_F3)) {
+    showArenaOverlay = !showArenaOverlay;
+  }
+  if (IsKeyPressed(KEY_F4) && lowRes.scale >= 2) {
+    lowRes.enabled = !lowRes.enabled;
+  }
+  if (IsKeyPressed(KEY_F6)) {
+    chunkCache.enabled = !chunkCache.enabled;
+  }
+  if (IsKeyPressed(KEY_F7) && ground.hasShader) {
+    ground.useShader = !ground.useShader;
+  }
+  if (IsKeyPressed(KEY_F10)) {
+    autosaver.mode = (autosaver.mode + 1) % AUTOSAVE_MODE_MAX;
+    printf("autosave mode: %s\n", autosaveModeNames[autosaver.mode]);
+  }
 
-      /* Debug Rectangles  */
-      /* DrawRectangleRec(bounds, col); */
+  // Re-renders the HUD texture only if a value it shows changed
+  UpdateHud(&hud, world);
+  UpdateGroundLayer(&ground, world);
+  // Re-renders only visible chunks whose static entities changed
+  UpdateChunkCache(&chunkCache, world, world->screenWidth,
+                   world->screenHeight);
 
-      // make collectibles bounce
-      Vector2 translation = v2(0, 0);
-      if (existing_entity->is_item) {
-        translation.y = sin_breathe(GetTime(), 5.0) * 10;
-      }
+  //----------------------------------------------------------------------------------
 
-      DrawTextureEx(sprite, Vector2Add(existing_entity->pos, translation), 0.0f,
-                    scale, RAYWHITE);
-
-      if (existing_entity->is_destroyable_world_item && mouseInBounds &&
-          IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
-        existing_entity->health -= 1;
-        if (existing_entity->health <= 0) {
-          existing_entity->is_valid = false;
-          if (existing_entity->archetype == arch_weed) {
-            SetupItemWood(existing_entity->pos);
-          }
-        }
-      }
+  // Draw
+  //----------------------------------------------------------------------------------
+  if (lowRes.enabled) {
+    BeginLowResMode(&lowRes, world->camera, world->backgroundColor);
+    DrawWorld(world, mouseRectangle);
+    EndLowResMode();
+  }
 
-      if (existing_entity->is_item &&
-          fabs(Vector2Distance(world->player->pos, existing_entity->pos)) <
-              playerPickupRadius) {
-        existing_entity->is_valid = false;
-        world->inventory[existing_entity->archetype] += 1;
-      }
+  BeginDrawing();
 
-      // DEBUG - print all entities' positions below them
-      /* char posStr[100]; */
-      /* sprintf(posStr, "(%.2f, %.2f)", existing_entity->pos.x, */
-      /*         existing_entity->pos.y); */
-      /* DrawText(posStr, existing_entity->pos.x, existing_entity->pos.y +
-       * 30,
-       */
-      /*          20, RED); */
-    }
+  if (lowRes.enabled) {
+    DrawLowResTarget(&lowRes);
+  } else {
+    ClearBackground(world->backgroundColor);
+    BeginMode2D(world->camera);
+    DrawWorld(world, mouseRectangle);
+    EndMode2D();
   }
 
-  EndMode2D();
-
-  int titleFontX = world->screenWidth - 300;
-  int titleFontY = 10;
-  int titleFontSize = 40;
-  DrawText(gameTitle, titleFontX, titleFontY, titleFontSize, RED);
-
-  Temp_Arena_Memory tmp = temp_arena_memory_begin(arena);
-  // NOTE: not sure that 16 is big enough once the integer gets up to a
-  // certain size(?)
-  char *timeStr = arena_alloc(arena, 16);
-  /* printf("TMP ARENA ALLOCD: current offset - %lu, previous offset - %lu,
-   * "
-   */
-  /*        "Arena Size - %llu", */
-  /*        a.curr_offset, a.prev_offset, ARENA_SIZE); */
-  /* char timeStr[16]; */
-  sprintf(timeStr, "Day %d, %02d:%02d", world->dayCount + 1,
-          world->timeInMinutes / 60, world->timeInMinutes % 60);
-  DrawText(timeStr, titleFontX, titleFontY + 30, titleFontSize, BLACK);
-  temp_arena_memory_end(tmp);
-  /* printf("TMP ARENA RELEASED: current offset - %lu, previous offset -
-   * %lu,
-   * " */
-  /*        "Arena Size - %llu", */
-  /*        a.curr_offset, a.prev_offset, ARENA_SIZE); */
-
-  // TODO: is there any reason to put these strings in the temp_arena rather
-  // than the stack
-  DrawText("Inventory:", titleFontX, titleFontY + 50, titleFontSize, RED);
-  for (int i = 0; i < MAX_INVENTORY_COUNT; i++) {
-    if (world->inventory[i] > 0) {
-
-      char posStr[1000];
-      sprintf(posStr, "%s: %d", getArchetypeName(i), world->inventory[i]);
-      DrawText(posStr, titleFontX, titleFontY + 30 * (i + 2), titleFontSize,
-               RED);
-    }
-  }
+  DrawHud(&hud, world->screenWidth - HUD_WIDTH, 0);
 
-  DrawRectangle(titleFontX, titleFontY + 200, 50, world->energy * 5,
-                world->energy > 30 ? GREEN : RED);
+  if (showArenaOverlay) {
+    DrawMemoryOverlay(memory, 10, 10);
+  }
 
   /* Debug Render Mouse Position */
   /* char posStr[1000]; */
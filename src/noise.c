@@ -0,0 +1,311 @@
+//
+// Seeded value noise for world generation
+//
+// Every integer lattice point gets a pseudo random value from a hash of its
+// coordinates and the seed, and points in between are blended with a
+// smoothstep. fbm_noise sums octaves at doubling frequency and halving
+// amplitude. Everything is deterministic for a given seed, so a chunk comes
+// out the same no matter when or in what order it's generated.
+//
+// Terrain samples whole rows of tiles at a time, so fbm_noise_row has SSE2
+// and AVX2 versions that do 4 or 8 samples per instruction, picked at
+// runtime from what the CPU supports. They do the same float operations in
+// the same order as the scalar code (no FMA), so every version returns
+// bit-identical results - the scalar one is the reference.
+//
+
+#if defined(__x86_64__) || defined(__i386__)
+#define NOISE_X86 1
+#include <immintrin.h>
+#else
+#define NOISE_X86 0
+#endif
+
+typedef enum NoiseIsa {
+  noise_isa_scalar = 0,
+  noise_isa_sse2,
+  noise_isa_avx2,
+  NOISE_ISA_MAX
+} NoiseIsa;
+
+const char *noiseIsaNames[NOISE_ISA_MAX] = {
+    [noise_isa_scalar] = "scalar",
+    [noise_isa_sse2] = "sse2",
+    [noise_isa_avx2] = "avx2",
+};
+
+// Lattice hash constants - 32 bit so the vector versions only need 32 bit
+// multiplies
+#define NOISE_PRIME_X 0x9e3779b1u
+#define NOISE_PRIME_Y 0x85ebca77u
+#define NOISE_PRIME_SEED 0xc2b2ae3du
+#define NOISE_MIX_A 0x2c1b3c6du
+#define NOISE_MIX_B 0x297a2d39u
+
+uint32_t noise_hash(uint32_t seed, int x, int y) {
+  uint32_t h = (uint32_t)x * NOISE_PRIME_X + (uint32_t)y * NOISE_PRIME_Y +
+               seed * NOISE_PRIME_SEED;
+  h ^= h >> 15;
+  h *= NOISE_MIX_A;
+  h ^= h >> 12;
+  h *= NOISE_MIX_B;
+  h ^= h >> 15;
+  return h;
+}
+
+// 0..1 from a lattice point
+float noise_lattice(uint32_t seed, int x, int y) {
+  return (float)(noise_hash(seed, x, y) >> 8) * (1.0f / 16777216.0f);
+}
+
+float noise_smooth(float t) { return t * t * (3.0f - 2.0f * t); }
+
+// 0..1, one lattice cell per unit
+float value_noise(uint32_t seed, float x, float y) {
+  float fx = floorf(x);
+  float fy = floorf(y);
+  int ix = (int)fx;
+  int iy = (int)fy;
+  float tx = noise_smooth(x - fx);
+  float ty = noise_smooth(y - fy);
+
+  float a = noise_lattice(seed, ix, iy);
+  float b = noise_lattice(seed, ix + 1, iy);
+  float c = noise_lattice(seed, ix, iy + 1);
+  float d = noise_lattice(seed, ix + 1, iy + 1);
+  float top = a + (b - a) * tx;
+  float bottom = c + (d - c) * tx;
+  return top + (bottom - top) * ty;
+}
+
+// 0..1, octaves of value_noise each at twice the frequency and half the
+// weight of the last
+float fbm_noise(uint32_t seed, float x, float y, int octaves) {
+  float sum = 0;
+  float weight = 0;
+  float amplitude = 1;
+  for (int i = 0; i < octaves; i++) {
+    sum += value_noise(seed + i, x, y) * amplitude;
+    weight += amplitude;
+    amplitude *= 0.5f;
+    x *= 2;
+    y *= 2;
+  }
+  return sum / weight;
+}
+
+// out[i] = fbm_noise at ((x + i) * scale, y * scale) for i < count
+void fbm_noise_row_scalar(uint32_t seed, int x, int y, float scale, int count,
+                          int octaves, float *out) {
+  for (int i = 0; i < count; i++) {
+    out[i] = fbm_noise(seed, (float)(x + i) * scale, (float)y * scale,
+                       octaves);
+  }
+}
+
+#if NOISE_X86
+
+// SSE2 has no 32 bit multiply - two 32x32->64 multiplies of the even and
+// odd lanes, low halves shuffled back together
+static inline __m128i noise_mullo_sse2(__m128i a, __m128i b) {
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// or SSE4.1's floor - truncate, then step down where that rounded up
+static inline __m128 noise_floor_sse2(__m128 x, __m128i *whole) {
+  __m128i truncated = _mm_cvttps_epi32(x);
+  __m128 t = _mm_cvtepi32_ps(truncated);
+  __m128i above = _mm_castps_si128(_mm_cmpgt_ps(t, x)); // -1 where t > x
+  *whole = _mm_add_epi32(truncated, above);
+  return _mm_cvtepi32_ps(*whole);
+}
+
+// The row part of the hash (y and seed) is the same for every lane
+static inline __m128 noise_lattice_sse2(__m128i ix, uint32_t rowHash) {
+  __m128i h = _mm_add_epi32(
+      noise_mullo_sse2(ix, _mm_set1_epi32((int)NOISE_PRIME_X)),
+      _mm_set1_epi32((int)rowHash));
+  h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+  h = noise_mullo_sse2(h, _mm_set1_epi32((int)NOISE_MIX_A));
+  h = _mm_xor_si128(h, _mm_srli_epi32(h, 12));
+  h = noise_mullo_sse2(h, _mm_set1_epi32((int)NOISE_MIX_B));
+  h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+  return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(h, 8)),
+                    _mm_set1_ps(1.0f / 16777216.0f));
+}
+
+static inline __m128 noise_smooth_sse2(__m128 t) {
+  return _mm_mul_ps(_mm_mul_ps(t, t),
+                    _mm_sub_ps(_mm_set1_ps(3.0f),
+                               _mm_mul_ps(_mm_set1_ps(2.0f), t)));
+}
+
+static inline __m128 noise_lerp_sse2(__m128 a, __m128 b, __m128 t) {
+  return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+}
+
+__attribute__((target("sse2"))) void
+fbm_noise_row_sse2(uint32_t seed, int x, int y, float scale, int count,
+                   int octaves, float *out) {
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 px = _mm_mul_ps(
+        _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(x + i),
+                                      _mm_setr_epi32(0, 1, 2, 3))),
+        _mm_set1_ps(scale));
+    float py = (float)y * scale;
+    __m128 sum = _mm_setzero_ps();
+    float weight = 0;
+    float amplitude = 1;
+    for (int o = 0; o < octaves; o++) {
+      uint32_t octaveSeed = seed + o;
+      __m128i ix;
+      __m128 fx = noise_floor_sse2(px, &ix);
+      __m128 tx = noise_smooth_sse2(_mm_sub_ps(px, fx));
+      float fy = floorf(py);
+      int iy = (int)fy;
+      float ty = noise_smooth(py - fy);
+      uint32_t top = (uint32_t)iy * NOISE_PRIME_Y + octaveSeed * NOISE_PRIME_SEED;
+      uint32_t bottom = top + NOISE_PRIME_Y;
+      __m128i ix1 = _mm_add_epi32(ix, _mm_set1_epi32(1));
+
+      __m128 a = noise_lattice_sse2(ix, top);
+      __m128 b = noise_lattice_sse2(ix1, top);
+      __m128 c = noise_lattice_sse2(ix, bottom);
+      __m128 d = noise_lattice_sse2(ix1, bottom);
+      __m128 value = noise_lerp_sse2(noise_lerp_sse2(a, b, tx),
+                                     noise_lerp_sse2(c, d, tx),
+                                     _mm_set1_ps(ty));
+      sum = _mm_add_ps(sum, _mm_mul_ps(value, _mm_set1_ps(amplitude)));
+      weight += amplitude;
+      amplitude *= 0.5f;
+      px = _mm_mul_ps(px, _mm_set1_ps(2.0f));
+      py *= 2;
+    }
+    _mm_storeu_ps(&out[i], _mm_div_ps(sum, _mm_set1_ps(weight)));
+  }
+  fbm_noise_row_scalar(seed, x + i, y, scale, count - i, octaves, &out[i]);
+}
+
+__attribute__((target("avx2"))) static inline __m256
+noise_lattice_avx2(__m256i ix, uint32_t rowHash) {
+  __m256i h = _mm256_add_epi32(
+      _mm256_mullo_epi32(ix, _mm256_set1_epi32((int)NOISE_PRIME_X)),
+      _mm256_set1_epi32((int)rowHash));
+  h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+  h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int)NOISE_MIX_A));
+  h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 12));
+  h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int)NOISE_MIX_B));
+  h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+  return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(h, 8)),
+                       _mm256_set1_ps(1.0f / 16777216.0f));
+}
+
+__attribute__((target("avx2"))) static inline __m256
+noise_smooth_avx2(__m256 t) {
+  return _mm256_mul_ps(_mm256_mul_ps(t, t),
+                       _mm256_sub_ps(_mm256_set1_ps(3.0f),
+                                     _mm256_mul_ps(_mm256_set1_ps(2.0f), t)));
+}
+
+__attribute__((target("avx2"))) static inline __m256
+noise_lerp_avx2(__m256 a, __m256 b, __m256 t) {
+  return _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), t));
+}
+
+__attribute__((target("avx2"))) void
+fbm_noise_row_avx2(uint32_t seed, int x, int y, float scale, int count,
+                   int octaves, float *out) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 px = _mm256_mul_ps(
+        _mm256_cvtepi32_ps(_mm256_add_epi32(
+            _mm256_set1_epi32(x + i), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7))),
+        _mm256_set1_ps(scale));
+    float py = (float)y * scale;
+    __m256 sum = _mm256_setzero_ps();
+    float weight = 0;
+    float amplitude = 1;
+    for (int o = 0; o < octaves; o++) {
+      uint32_t octaveSeed = seed + o;
+      __m256 fx = _mm256_floor_ps(px);
+      __m256i ix = _mm256_cvtps_epi32(fx);
+      __m256 tx = noise_smooth_avx2(_mm256_sub_ps(px, fx));
+      float fy = floorf(py);
+      int iy = (int)fy;
+      float ty = noise_smooth(py - fy);
+      uint32_t top = (uint32_t)iy * NOISE_PRIME_Y + octaveSeed * NOISE_PRIME_SEED;
+      uint32_t bottom = top + NOISE_PRIME_Y;
+      __m256i ix1 = _mm256_add_epi32(ix, _mm256_set1_epi32(1));
+
+      __m256 a = noise_lattice_avx2(ix, top);
+      __m256 b = noise_lattice_avx2(ix1, top);
+      __m256 c = noise_lattice_avx2(ix, bottom);
+      __m256 d = noise_lattice_avx2(ix1, bottom);
+      __m256 value = noise_lerp_avx2(noise_lerp_avx2(a, b, tx),
+                                     noise_lerp_avx2(c, d, tx),
+                                     _mm256_set1_ps(ty));
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(value, _mm256_set1_ps(amplitude)));
+      weight += amplitude;
+      amplitude *= 0.5f;
+      px = _mm256_mul_ps(px, _mm256_set1_ps(2.0f));
+      py *= 2;
+    }
+    _mm256_storeu_ps(&out[i], _mm256_div_ps(sum, _mm256_set1_ps(weight)));
+  }
+  fbm_noise_row_scalar(seed, x + i, y, scale, count - i, octaves, &out[i]);
+}
+
+#endif
+
+bool noise_isa_supported(NoiseIsa isa) {
+  switch (isa) {
+  case noise_isa_scalar:
+    return true;
+#if NOISE_X86
+  case noise_isa_sse2:
+    return __builtin_cpu_supports("sse2");
+  case noise_isa_avx2:
+    return __builtin_cpu_supports("avx2");
+#endif
+  default:
+    return false;
+  }
+}
+
+NoiseIsa noise_best_isa() {
+  for (int isa = NOISE_ISA_MAX - 1; isa > noise_isa_scalar; isa--) {
+    if (noise_isa_supported(isa)) {
+      return isa;
+    }
+  }
+  return noise_isa_scalar;
+}
+
+// isa has to be supported - see noise_isa_supported
+void fbm_noise_row_isa(NoiseIsa isa, uint32_t seed, int x, int y, float scale,
+                       int count, int octaves, float *out) {
+  switch (isa) {
+#if NOISE_X86
+  case noise_isa_sse2:
+    fbm_noise_row_sse2(seed, x, y, scale, count, octaves, out);
+    return;
+  case noise_isa_avx2:
+    fbm_noise_row_avx2(seed, x, y, scale, count, octaves, out);
+    return;
+#endif
+  default:
+    fbm_noise_row_scalar(seed, x, y, scale, count, octaves, out);
+    return;
+  }
+}
+
+// out[i] = fbm_noise at ((x + i) * scale, y * scale) for i < count, with
+// the widest vector unit the CPU has
+void fbm_noise_row(uint32_t seed, int x, int y, float scale, int count,
+                   int octaves, float *out) {
+  fbm_noise_row_isa(noise_best_isa(), seed, x, y, scale, count, octaves, out);
+}
@@ -0,0 +1,173 @@
+//
+// Fixed-size pool allocator carved out of an Arena
+//
+// Every block is the same size. Freed blocks go on an intrusive free list
+// (the link lives inside the free block itself) so alloc and free are both
+// O(1). Blocks that have never been handed out are bumped from the end of
+// the used range instead of being threaded onto the free list at init, so a
+// big pool on a reserved arena doesn't touch pages it never uses.
+//
+
+typedef struct PoolFreeNode PoolFreeNode;
+struct PoolFreeNode {
+  PoolFreeNode *next;
+};
+
+typedef struct PoolStats {
+  size_t in_use;
+  size_t peak_in_use;
+  size_t total_allocs;
+  size_t total_frees;
+  size_t failed_allocs; // pool was full
+} PoolStats;
+
+typedef struct Pool {
+  unsigned char *buf;
+  size_t block_size; // requested size rounded up to the block alignment
+  size_t block_count;
+  size_t bump_index; // blocks at or past this index have never been used
+  PoolFreeNode *free_list;
+  // Optional - one bit per block, set while allocated, for fast iteration
+  uint64_t *occupied;
+  PoolStats stats;
+} Pool;
+
+// Returns false if the arena couldn't fit the pool
+bool pool_init_align(Pool *p, Arena *a, size_t block_size, size_t block_align,
+                     size_t block_count, bool track_occupancy) {
+  memset(p, 0, sizeof(*p));
+  if (block_size < sizeof(PoolFreeNode)) {
+    block_size = sizeof(PoolFreeNode);
+  }
+  if (block_align < DEFAULT_ALIGNMENT) {
+    block_align = DEFAULT_ALIGNMENT;
+  }
+  block_size = align_forward(block_size, block_align);
+
+  // Pool memory is never read before it is handed out and zeroed
+  p->buf = arena_alloc_align_flags(a, block_size * block_count, block_align,
+                                   arena_tag_pool, arena_flag_no_zero);
+  if (!p->buf) {
+    return false;
+  }
+  if (track_occupancy) {
+    p->occupied = arena_alloc_tagged(
+        a, ((block_count + 63) / 64) * sizeof(uint64_t), arena_tag_pool);
+    if (!p->occupied) {
+      return false;
+    }
+  }
+  p->block_size = block_size;
+  p->block_count = block_count;
+  return true;
+}
+
+bool pool_init(Pool *p, Arena *a, size_t block_size, size_t block_count,
+               bool track_occupancy) {
+  return pool_init_align(p, a, block_size, DEFAULT_ALIGNMENT, block_count,
+                         track_occupancy);
+}
+
+size_t pool_block_index(Pool *p, void *ptr) {
+  return ((unsigned char *)ptr - p->buf) / p->block_size;
+}
+
+void *pool_block(Pool *p, size_t index) {
+  return p->buf + index * p->block_size;
+}
+
+bool pool_is_occupied(Pool *p, size_t index) {
+  return (p->occupied[index / 64] >> (index % 64)) & 1;
+}
+
+// Zeroed like arena_alloc. Returns NULL when the pool is full.
+void *pool_alloc(Pool *p) {
+  void *ptr = NULL;
+  if (p->free_list) {
+    ptr = p->free_list;
+    p->free_list = p->free_list->next;
+  } else if (p->bump_index < p->block_count) {
+    ptr = pool_block(p, p->bump_index++);
+  } else {
+    p->stats.failed_allocs += 1;
+    return NULL;
+  }
+
+  memset(ptr, 0, p->block_size);
+  if (p->occupied) {
+    size_t index = pool_block_index(p, ptr);
+    p->occupied[index / 64] |= 1ull << (index % 64);
+  }
+  p->stats.total_allocs += 1;
+  p->stats.in_use += 1;
+  if (p->stats.in_use > p->stats.peak_in_use) {
+    p->stats.peak_in_use = p->stats.in_use;
+  }
+  return ptr;
+}
+
+void pool_free(Pool *p, void *ptr) {
+  if (ptr == NULL) {
+    return;
+  }
+  unsigned char *mem = (unsigned char *)ptr;
+  assert(p->buf <= mem && mem < p->buf + p->block_size * p->block_count &&
+         "Memory is out of bounds of the buffer in this pool");
+
+  if (p->occupied) {
+    size_t index = pool_block_index(p, ptr);
+    p->occupied[index / 64] &= ~(1ull << (index % 64));
+  }
+  PoolFreeNode *node = (PoolFreeNode *)ptr;
+  node->next = p->free_list;
+  p->free_list = node;
+  p->stats.total_frees += 1;
+  p->stats.in_use -= 1;
+}
+
+void pool_free_all(Pool *p) {
+  p->free_list = NULL;
+  p->bump_index = 0;
+  p->stats.in_use = 0;
+  if (p->occupied) {
+    memset(p->occupied, 0, ((p->block_count + 63) / 64) * sizeof(uint64_t));
+  }
+}
+
+// Index of the first allocated block at or after 'from', or -1. Needs
+// track_occupancy. Skips 64 empty blocks per word, so sparse pools iterate
+// in time proportional to what's live, eg.
+//   for (long i = pool_next_occupied(p, 0); i >= 0;
+//        i = pool_next_occupied(p, i + 1))
+long pool_next_occupied(Pool *p, size_t from) {
+  size_t limit = p->bump_index; // nothing past here was ever allocated
+  while (from < limit) {
+    uint64_t word = p->occupied[from / 64] >> (from % 64);
+    if (word) {
+      size_t index = from + __builtin_ctzll(word);
+      return index < limit ? (long)index : -1;
+    }
+    from = (from / 64 + 1) * 64;
+  }
+  return -1;
+}
+
+// Typed wrapper so callers don't cast, eg.
+//   POOL_DEFINE(Particle, ParticlePool, particle_pool)
+//   ParticlePool particles;
+//   particle_pool_init(&particles, &memory->session, 4096, true);
+//   Particle *p = particle_pool_alloc(&particles);
+#define POOL_DEFINE(Type, PoolType, prefix)                                    \
+  typedef struct PoolType {                                                    \
+    Pool pool;                                                                 \
+  } PoolType;                                                                  \
+  bool prefix##_init(PoolType *p, Arena *a, size_t count,                      \
+                     bool track_occupancy) {                                   \
+    return pool_init_align(&p->pool, a, sizeof(Type), __alignof__(Type),      \
+                           count, track_occupancy);                            \
+  }                                                                            \
+  Type *prefix##_alloc(PoolType *p) { return (Type *)pool_alloc(&p->pool); }   \
+  void prefix##_free(PoolType *p, Type *item) { pool_free(&p->pool, item); }   \
+  Type *prefix##_at(PoolType *p, size_t index) {                               \
+    return (Type *)pool_block(&p->pool, index);                                \
+  }
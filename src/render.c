@@ -0,0 +1,390 @@
+//
+// Low resolution world target
+//
+// The world is pixel art drawn at spriteScale under the camera's zoom, so
+// one sprite pixel covers zoom * spriteScale screen pixels (5x5 by
+// default). Drawing the world into a texture at one texel per sprite pixel
+// and blowing it up with nearest-neighbour at the end gives the same
+// picture for a 25th of the fragment work. The HUD is drawn on top at full
+// resolution.
+//
+
+typedef struct LowResTarget {
+  RenderTexture2D target;
+  int scale;        // screen pixels per texel
+  Vector2 subpixel; // where the last frame has to be blitted, in screen space
+  bool enabled;
+} LowResTarget;
+
+// Returns false if the zoom is too low for it to be worth it
+bool InitLowResTarget(LowResTarget *t, int screenWidth, int screenHeight,
+                      float zoom) {
+  memset(t, 0, sizeof(*t));
+  t->scale = (int)(zoom * spriteScale + 0.5f);
+  if (t->scale < 2) {
+    return false;
+  }
+  // A spare texel on every side to cover the sub-texel scroll
+  t->target = LoadRenderTexture((screenWidth + t->scale - 1) / t->scale + 2,
+                                (screenHeight + t->scale - 1) / t->scale + 2);
+  SetTextureFilter(t->target.texture, TEXTURE_FILTER_POINT);
+  t->enabled = true;
+  return true;
+}
+
+void UnloadLowResTarget(LowResTarget *t) {
+  if (t->scale >= 2) {
+    UnloadRenderTexture(t->target);
+  }
+}
+
+// Must happen outside BeginDrawing/EndDrawing. Draw the world with the
+// normal world-space calls in between this and EndLowResMode.
+void BeginLowResMode(LowResTarget *t, Camera2D camera, Color background) {
+  // Snap the camera to whole texels so sprites don't shimmer as it moves,
+  // and make up the remainder when blitting so scrolling stays smooth
+  float texel = t->scale / camera.zoom; // world units per texel
+  Camera2D lowRes = camera;
+  lowRes.target = (Vector2){floorf(camera.target.x / texel) * texel,
+                            floorf(camera.target.y / texel) * texel};
+  lowRes.offset = (Vector2){floorf(camera.offset.x / t->scale) + 1,
+                            floorf(camera.offset.y / t->scale) + 1};
+  lowRes.zoom = camera.zoom / t->scale;
+
+  Vector2 scrolled =
+      Vector2Scale(Vector2Subtract(camera.target, lowRes.target), camera.zoom);
+  // Both terms are under a texel, so the blit lands less than two texels up
+  // and left of the screen corner - inside the spare border
+  Vector2 offsetRemainder =
+      Vector2Subtract(camera.offset, Vector2Scale(lowRes.offset, t->scale));
+  t->subpixel = Vector2Subtract(offsetRemainder, scrolled);
+
+  BeginTextureMode(t->target);
+  ClearBackground(background);
+  BeginMode2D(lowRes);
+}
+
+void EndLowResMode(void) {
+  EndMode2D();
+  EndTextureMode();
+}
+
+void DrawLowResTarget(LowResTarget *t) {
+  // Render textures are stored upside down
+  Texture2D texture = t->target.texture;
+  DrawTexturePro(texture,
+                 (Rectangle){0, 0, texture.width, -(float)texture.height},
+                 (Rectangle){t->subpixel.x, t->subpixel.y,
+                             texture.width * t->scale,
+                             texture.height * t->scale},
+                 v2(0, 0), 0.0f, WHITE);
+}
+
+//
+// Static layer chunk cache
+//
+// Rocks and berry bushes never move, so each visible chunk's static
+// entities are drawn once into a texture (one texel per sprite pixel) and
+// after that the chunk is a single quad. Weeds sway (entity_is_static
+// leaves out anything with a clip), so they're drawn every frame. The
+// world marks a chunk dirty whenever a static entity in it is spawned or
+// destroyed and only those chunks are redrawn.
+// Slots are recycled least recently used first.
+//
+
+#define CHUNK_CACHE_SLOTS 16
+// Sprites hang off the right and bottom of their tile, so each chunk's
+// texture overlaps its neighbours by this much
+#define CHUNK_CACHE_MARGIN_TILES 2
+
+typedef struct CachedChunk {
+  ChunkCoord coord;
+  RenderTexture2D target;
+  bool loaded; // target has been allocated
+  bool valid;  // target holds coord's current static entities
+  uint64_t lastUsedFrame;
+} CachedChunk;
+
+typedef struct ChunkCache {
+  Atlas *atlas;
+  CachedChunk slots[CHUNK_CACHE_SLOTS];
+  uint64_t frame;
+  size_t rebuilds;
+  bool enabled;
+} ChunkCache;
+
+const float chunkCacheWidth =
+    (CHUNK_TILES + CHUNK_CACHE_MARGIN_TILES) * TILE_WIDTH;
+
+void InitChunkCache(ChunkCache *cache, Atlas *atlas) {
+  memset(cache, 0, sizeof(*cache));
+  cache->atlas = atlas;
+  cache->enabled = true;
+}
+
+void UnloadChunkCache(ChunkCache *cache) {
+  for (int i = 0; i < CHUNK_CACHE_SLOTS; i++) {
+    if (cache->slots[i].loaded) {
+      UnloadRenderTexture(cache->slots[i].target);
+    }
+  }
+}
+
+CachedChunk *chunk_cache_find(ChunkCache *cache, ChunkCoord coord) {
+  for (int i = 0; i < CHUNK_CACHE_SLOTS; i++) {
+    CachedChunk *slot = &cache->slots[i];
+    if (slot->loaded && chunk_coord_eq(slot->coord, coord)) {
+      return slot;
+    }
+  }
+  return NULL;
+}
+
+// The least recently used slot, or NULL if every slot is in view
+CachedChunk *chunk_cache_evict(ChunkCache *cache) {
+  CachedChunk *oldest = NULL;
+  for (int i = 0; i < CHUNK_CACHE_SLOTS; i++) {
+    CachedChunk *slot = &cache->slots[i];
+    if (slot->lastUsedFrame == cache->frame && slot->loaded) {
+      continue;
+    }
+    if (!oldest || !slot->loaded ||
+        slot->lastUsedFrame < oldest->lastUsedFrame) {
+      oldest = slot;
+      if (!slot->loaded) {
+        break;
+      }
+    }
+  }
+  return oldest;
+}
+
+void chunk_cache_rebuild(ChunkCache *cache, CachedChunk *slot, World *world) {
+  if (!slot->loaded) {
+    int size = chunkCacheWidth / spriteScale;
+    slot->target = LoadRenderTexture(size, size);
+    SetTextureFilter(slot->target.texture, TEXTURE_FILTER_POINT);
+    slot->loaded = true;
+  }
+
+  Camera2D camera = {0};
+  camera.target = v2(slot->coord.x * chunkWidth, slot->coord.y * chunkWidth);
+  camera.zoom = 1.0f / spriteScale;
+
+  BeginTextureMode(slot->target);
+  ClearBackground(BLANK);
+  BeginMode2D(camera);
+  for (int i = 0; i < world->entityHighWater; i++) {
+    Entity *entity = &world->entities[i];
+    if (entity->is_valid && entity_is_static(entity) &&
+        chunk_coord_eq(chunk_of(entity->pos), slot->coord)) {
+      DrawSprite(cache->atlas, entity->sprite_id, entity->pos, spriteScale,
+                 RAYWHITE);
+    }
+  }
+  EndMode2D();
+  EndTextureMode();
+
+  slot->valid = true;
+  cache->rebuilds++;
+}
+
+// Must happen outside BeginDrawing/EndDrawing and any texture mode
+void UpdateChunkCache(ChunkCache *cache, World *world, int screenWidth,
+                      int screenHeight) {
+  cache->frame++;
+
+  for (int i = 0; i < CHUNK_CACHE_SLOTS; i++) {
+    CachedChunk *slot = &cache->slots[i];
+    if (world->allChunksDirty) {
+      slot->valid = false;
+      continue;
+    }
+    for (int d = 0; d < world->dirtyChunkCount; d++) {
+      if (chunk_coord_eq(slot->coord, world->dirtyChunks[d])) {
+        slot->valid = false;
+      }
+    }
+  }
+  world->allChunksDirty = false;
+  world->dirtyChunkCount = 0;
+
+  if (!cache->enabled) {
+    return;
+  }
+
+  // Every chunk whose texture, margin included, touches the screen
+  Camera2D camera = world->camera;
+  Vector2 topLeft = GetScreenToWorld2D(v2(0, 0), camera);
+  Vector2 bottomRight = GetScreenToWorld2D(v2(screenWidth, screenHeight), camera);
+  float margin = chunkCacheWidth - chunkWidth;
+  ChunkCoord first = chunk_of(Vector2SubtractValue(topLeft, margin));
+  ChunkCoord last = chunk_of(bottomRight);
+  for (int y = first.y; y <= last.y; y++) {
+    for (int x = first.x; x <= last.x; x++) {
+      ChunkCoord coord = {x, y};
+      CachedChunk *slot = chunk_cache_find(cache, coord);
+      if (!slot) {
+        slot = chunk_cache_evict(cache);
+        if (!slot) {
+          continue; // more chunks on screen than slots
+        }
+        slot->coord = coord;
+        slot->valid = false;
+      }
+      if (!slot->valid) {
+        chunk_cache_rebuild(cache, slot, world);
+      }
+      slot->lastUsedFrame = cache->frame;
+    }
+  }
+}
+
+// Call in world space, before the dynamic entities
+void DrawChunkCache(ChunkCache *cache) {
+  for (int i = 0; i < CHUNK_CACHE_SLOTS; i++) {
+    CachedChunk *slot = &cache->slots[i];
+    if (!slot->valid || slot->lastUsedFrame != cache->frame) {
+      continue;
+    }
+    Texture2D texture = slot->target.texture;
+    DrawTexturePro(texture,
+                   (Rectangle){0, 0, texture.width, -(float)texture.height},
+                   (Rectangle){slot->coord.x * chunkWidth,
+                               slot->coord.y * chunkWidth, chunkCacheWidth,
+                               chunkCacheWidth},
+                   v2(0, 0), 0.0f, WHITE);
+  }
+}
+
+//
+// Ground layer
+//
+// The tile indices around the camera live in a one byte per tile texture.
+// The ground is a single quad over that window, and a fragment shader
+// turns each pixel into its tile's index and then a texel of the tileset in
+// the atlas. Only the pixels on screen run the shader, and the indices are
+// re-uploaded only when the camera moves into a new chunk. If the shader
+// doesn't compile, the fallback draws one atlas quad per visible tile.
+//
+
+const char *groundFragmentShader =
+    "#version 330\n"
+    "in vec2 fragTexCoord;\n"
+    "in vec4 fragColor;\n"
+    "uniform sampler2D texture0;  // tile indices, one texel per tile\n"
+    "uniform sampler2D tileset;   // the atlas\n"
+    "uniform vec2 tilesetOrigin;  // first ground tile in the atlas\n"
+    "uniform float tileTexels;\n"
+    "uniform float windowTiles;\n"
+    "out vec4 finalColor;\n"
+    "void main() {\n"
+    "  vec2 tile = fragTexCoord * windowTiles;\n"
+    "  vec2 cell = floor(tile);\n"
+    "  float index = floor(texelFetch(texture0, ivec2(cell), 0).r * 255.0 + "
+    "0.5);\n"
+    "  vec2 texel = floor((tile - cell) * tileTexels);\n"
+    "  vec2 at = tilesetOrigin + vec2(index * tileTexels, 0.0) + texel;\n"
+    "  finalColor = texelFetch(tileset, ivec2(at), 0) * fragColor;\n"
+    "}\n";
+
+typedef struct GroundLayer {
+  Atlas *atlas;
+  GroundWindow window;
+  Texture2D indexTexture;
+  Shader shader;
+  int tilesetLoc;
+  bool hasShader; // false if the shader failed to compile
+  bool useShader;
+} GroundLayer;
+
+void InitGroundLayer(GroundLayer *ground, Atlas *atlas) {
+  memset(ground, 0, sizeof(*ground));
+  ground->atlas = atlas;
+  Image indices = {.data = ground->window.indices,
+                   .width = GROUND_WINDOW_TILES,
+                   .height = GROUND_WINDOW_TILES,
+                   .mipmaps = 1,
+                   .format = PIXELFORMAT_UNCOMPRESSED_GRAYSCALE};
+  ground->indexTexture = LoadTextureFromImage(indices);
+
+  ground->shader = LoadShaderFromMemory(NULL, groundFragmentShader);
+  ground->hasShader = ground->shader.id != rlGetShaderIdDefault();
+  ground->useShader = ground->hasShader;
+  if (ground->hasShader) {
+    Vector2 origin = {atlas->ground.x, atlas->ground.y};
+    float tileTexels = GROUND_TILE_TEXELS;
+    float windowTiles = GROUND_WINDOW_TILES;
+    ground->tilesetLoc = GetShaderLocation(ground->shader, "tileset");
+    SetShaderValue(ground->shader,
+                   GetShaderLocation(ground->shader, "tilesetOrigin"), &origin,
+                   SHADER_UNIFORM_VEC2);
+    SetShaderValue(ground->shader,
+                   GetShaderLocation(ground->shader, "tileTexels"),
+                   &tileTexels, SHADER_UNIFORM_FLOAT);
+    SetShaderValue(ground->shader,
+                   GetShaderLocation(ground->shader, "windowTiles"),
+                   &windowTiles, SHADER_UNIFORM_FLOAT);
+  }
+}
+
+void UnloadGroundLayer(GroundLayer *ground) {
+  UnloadTexture(ground->indexTexture);
+  if (ground->hasShader) {
+    UnloadShader(ground->shader);
+  }
+}
+
+void UpdateGroundLayer(GroundLayer *ground, World *world) {
+  if (UpdateGroundWindow(&ground->window, world->seed,
+                         chunk_of(world->camera.target), &world->chunks)) {
+    UpdateTexture(ground->indexTexture, ground->window.indices);
+  }
+}
+
+// Call in world space, before anything else in the world
+void DrawGroundLayer(GroundLayer *ground, World *world) {
+  GroundWindow *window = &ground->window;
+  Rectangle bounds = {window->originX * tileWidth,
+                      window->originY * tileWidth,
+                      GROUND_WINDOW_TILES * tileWidth,
+                      GROUND_WINDOW_TILES * tileWidth};
+
+  if (ground->useShader) {
+    BeginShaderMode(ground->shader);
+    SetShaderValueTexture(ground->shader, ground->tilesetLoc,
+                          ground->atlas->texture);
+    DrawTexturePro(ground->indexTexture,
+                   (Rectangle){0, 0, GROUND_WINDOW_TILES, GROUND_WINDOW_TILES},
+                   bounds, v2(0, 0), 0.0f, WHITE);
+    EndShaderMode();
+    return;
+  }
+
+  // Fallback - one quad per visible tile
+  Vector2 topLeft = GetScreenToWorld2D(v2(0, 0), world->camera);
+  Vector2 bottomRight = GetScreenToWorld2D(
+      v2(world->screenWidth, world->screenHeight), world->camera);
+  int firstX = Clamp(floorf(topLeft.x / tileWidth) - window->originX, 0,
+                     GROUND_WINDOW_TILES - 1);
+  int firstY = Clamp(floorf(topLeft.y / tileWidth) - window->originY, 0,
+                     GROUND_WINDOW_TILES - 1);
+  int lastX = Clamp(floorf(bottomRight.x / tileWidth) - window->originX, 0,
+                    GROUND_WINDOW_TILES - 1);
+  int lastY = Clamp(floorf(bottomRight.y / tileWidth) - window->originY, 0,
+                    GROUND_WINDOW_TILES - 1);
+  Rectangle src = ground->atlas->ground;
+  src.width = GROUND_TILE_TEXELS;
+  for (int y = firstY; y <= lastY; y++) {
+    for (int x = firstX; x <= lastX; x++) {
+      GroundTile tile = window->indices[y * GROUND_WINDOW_TILES + x];
+      Rectangle tileSrc = src;
+      tileSrc.x += tile * GROUND_TILE_TEXELS;
+      DrawTexturePro(ground->atlas->texture, tileSrc,
+                     (Rectangle){(window->originX + x) * tileWidth,
+                                 (window->originY + y) * tileWidth, tileWidth,
+                                 tileWidth},
+                     v2(0, 0), 0.0f, WHITE);
+    }
+  }
+}
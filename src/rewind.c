@@ -0,0 +1,380 @@
+//
+// Rewind
+//
+// Keeps the last few seconds of the World so it can be scrubbed back and
+// forth while debugging. Every tick the World is packed - its scalar
+// fields, the entities up to the high-water mark with their per-entity
+// arrays, and the chunk table's states - and stored in a ring buffer
+// compressed (compress.c). Most packs are XORed with the last keyframe
+// first, so what didn't change since then is zeros and costs next to
+// nothing once compressed. The oldest frame is always a keyframe: when a
+// keyframe is evicted the deltas against it go with it.
+//
+// Capturing packs and compresses the whole World every tick - several ms a
+// frame with the entity array full (the rewind bench) - so it's off until
+// turned on with SetRewindRecording.
+//
+// Restoring leaves ChunkInfo.data NULL, so the streamer has to be reset
+// after scrubbing (ResetStreamer).
+//
+
+#include <stddef.h>
+
+#define REWIND_SECONDS 10
+#define REWIND_MAX_FRAMES (REWIND_SECONDS * 60) // captured once per tick
+#define REWIND_KEYFRAME_INTERVAL 60
+#define REWIND_BUFFER_SIZE MB(64)
+#define REWIND_MAX_CHUNKS 4096 // ticks with more aren't captured
+
+typedef struct RewindEntity {
+  SavedEntity saved;
+  float bobOffset;
+  uint16_t animFrame;
+} RewindEntity;
+
+typedef struct RewindChunk {
+  ChunkCoord coord;
+  uint8_t state;
+  bool modified;
+  bool unsaved;
+} RewindChunk;
+
+// The packed World, in the order the XOR lines up best - entities before
+// the chunk list, whose length changes more often
+typedef struct RewindHeader {
+  uint32_t entityCount;
+  uint32_t chunkCount;
+} RewindHeader;
+
+// The World's fields other than the per-entity arrays, which are packed
+// per entity, and the chunk table, which is packed as RewindChunks
+typedef struct RewindSpan {
+  size_t offset;
+  size_t size;
+} RewindSpan;
+
+// The chunk dirty list isn't packed - restoring marks every chunk dirty
+#define REWIND_SPAN_COUNT 4
+const RewindSpan rewindSpans[REWIND_SPAN_COUNT] = {
+    {offsetof(World, inventory),
+     offsetof(World, bobAmplitude) - offsetof(World, inventory)},
+    {offsetof(World, animClock), sizeof(double)},
+    {offsetof(World, playerFacingLeft), sizeof(bool)},
+    {offsetof(World, seed), sizeof(uint32_t)},
+};
+
+typedef struct RewindFrame {
+  size_t offset; // into the ring buffer
+  size_t size;   // compressed
+  size_t rawSize;
+  uint64_t keyframe; // the frame it's a delta against - itself if a keyframe
+} RewindFrame;
+
+typedef struct Rewind {
+  unsigned char *buffer; // ring of compressed frames, REWIND_BUFFER_SIZE
+  size_t head;           // where the next frame goes
+  // Frames by sequence number, kept at [oldest, next)
+  RewindFrame frames[REWIND_MAX_FRAMES];
+  uint64_t oldest;
+  uint64_t next;
+  // The newest keyframe packed, for making deltas
+  unsigned char *key;
+  size_t keySize; // 0 forces the next frame to be a keyframe
+  // Scratch, each big enough for any pack
+  size_t rawCapacity;
+  unsigned char *packed;
+  unsigned char *decoded;
+  unsigned char *encoded;
+  bool recording; // CaptureRewind does nothing while false
+  // Scrubbing
+  bool scrubbing;
+  uint64_t cursor; // the frame the World shows
+  // Stats
+  uint64_t captureNs; // last frame's
+  size_t bytesUsed;   // compressed, all frames kept
+  size_t rawBytes;    // the same frames packed
+} Rewind;
+
+size_t rewind_raw_capacity() {
+  size_t fixed = sizeof(RewindHeader);
+  for (int s = 0; s < REWIND_SPAN_COUNT; s++) {
+    fixed += rewindSpans[s].size;
+  }
+  return fixed + MAX_ENTITY_COUNT * sizeof(RewindEntity) +
+         REWIND_MAX_CHUNKS * sizeof(RewindChunk);
+}
+
+bool InitRewind(Rewind *r, Arena *arena) {
+  memset(r, 0, sizeof(*r));
+  r->rawCapacity = rewind_raw_capacity();
+  r->buffer = arena_alloc_nozero(arena, REWIND_BUFFER_SIZE);
+  r->key = arena_alloc_nozero(arena, r->rawCapacity);
+  r->packed = arena_alloc_nozero(arena, r->rawCapacity);
+  r->decoded = arena_alloc_nozero(arena, r->rawCapacity);
+  r->encoded = arena_alloc_nozero(arena, lz_compress_bound(r->rawCapacity));
+  if (!r->buffer || !r->key || !r->packed || !r->decoded || !r->encoded) {
+    return false;
+  }
+  // A forked autosave never reads history, and leaving these ~80 MB out of
+  // the child keeps fork() from copying their page tables
+  exclude_from_fork(r->buffer, r->encoded + lz_compress_bound(r->rawCapacity) -
+                                   r->buffer);
+  return true;
+}
+
+// Forgets every frame - call when the World is replaced
+void ResetRewind(Rewind *r) {
+  r->head = 0;
+  r->oldest = r->next = 0;
+  r->keySize = 0;
+  r->scrubbing = false;
+  r->bytesUsed = r->rawBytes = 0;
+}
+
+// Turning recording off drops every frame kept - starting again later
+// would leave a gap in the middle of the history
+void SetRewindRecording(Rewind *r, bool recording) {
+  if (!recording) {
+    ResetRewind(r);
+    r->captureNs = 0;
+  }
+  r->recording = recording;
+}
+
+// Returns the packed size, or 0 if the World doesn't fit
+size_t rewind_pack(World *world, unsigned char *out) {
+  if (world->chunks.count > REWIND_MAX_CHUNKS) {
+    return 0;
+  }
+  RewindHeader *header = (RewindHeader *)out;
+  unsigned char *cursor = out + sizeof(*header);
+  for (int s = 0; s < REWIND_SPAN_COUNT; s++) {
+    memcpy(cursor, (unsigned char *)world + rewindSpans[s].offset,
+           rewindSpans[s].size);
+    cursor += rewindSpans[s].size;
+  }
+
+  header->entityCount = world->entityHighWater;
+  for (int i = 0; i < world->entityHighWater; i++) {
+    RewindEntity entity;
+    memset(&entity, 0, sizeof(entity));
+    entity.saved = save_entity(world, &world->entities[i]);
+    entity.bobOffset = world->bobOffset[i];
+    entity.animFrame = world->animFrame[i];
+    memcpy(cursor, &entity, sizeof(entity));
+    cursor += sizeof(entity);
+  }
+
+  header->chunkCount = 0;
+  for (size_t i = 0; i < world->chunks.capacity; i++) {
+    ChunkTableEntry *entry = &world->chunks.entries[i];
+    if (!entry->hash) {
+      continue;
+    }
+    // what was in flight is requested again after the restore
+    RewindChunk chunk = {entry->key,
+                         entry->value.state == chunk_requested
+                             ? chunk_unloaded
+                             : entry->value.state,
+                         entry->value.modified, entry->value.unsaved};
+    memcpy(cursor, &chunk, sizeof(chunk));
+    cursor += sizeof(chunk);
+    header->chunkCount++;
+  }
+  return cursor - out;
+}
+
+void rewind_unpack(World *world, unsigned char *in) {
+  RewindHeader header;
+  memcpy(&header, in, sizeof(header));
+  unsigned char *cursor = in + sizeof(header);
+  int highWater = world->entityHighWater;
+  for (int s = 0; s < REWIND_SPAN_COUNT; s++) {
+    memcpy((unsigned char *)world + rewindSpans[s].offset, cursor,
+           rewindSpans[s].size);
+    cursor += rewindSpans[s].size;
+  }
+
+  for (uint32_t i = 0; i < header.entityCount; i++) {
+    RewindEntity entity;
+    memcpy(&entity, cursor, sizeof(entity));
+    cursor += sizeof(entity);
+    restore_entity(world, &world->entities[i], &entity.saved);
+    world->bobOffset[i] = entity.bobOffset;
+    world->animFrame[i] = entity.animFrame;
+  }
+  // spawned since
+  for (int i = header.entityCount; i < highWater; i++) {
+    world->entities[i].is_valid = false;
+  }
+
+  chunk_table_clear(&world->chunks);
+  for (uint32_t i = 0; i < header.chunkCount; i++) {
+    RewindChunk chunk;
+    memcpy(&chunk, cursor, sizeof(chunk));
+    cursor += sizeof(chunk);
+    ChunkInfo *info = chunk_table_put(&world->chunks, chunk.coord);
+    if (info) {
+      *info = (ChunkInfo){chunk.state, chunk.modified, chunk.unsaved, NULL};
+    }
+  }
+  // nothing the renderer has cached is from this World
+  world->dirtyChunkCount = 0;
+  world->allChunksDirty = true;
+}
+
+void rewind_evict_oldest(Rewind *r) {
+  RewindFrame *frame = &r->frames[r->oldest % REWIND_MAX_FRAMES];
+  r->bytesUsed -= frame->size;
+  r->rawBytes -= frame->rawSize;
+  r->oldest++;
+}
+
+bool rewind_overlaps(RewindFrame *frame, size_t offset, size_t size) {
+  return frame->offset < offset + size && offset < frame->offset + frame->size;
+}
+
+// Makes room for size bytes at the head, oldest frames first, and returns
+// where they go. The head only moves once the caller keeps the frame.
+size_t rewind_reserve(Rewind *r, size_t size) {
+  if (r->oldest < r->next && r->next - r->oldest == REWIND_MAX_FRAMES) {
+    rewind_evict_oldest(r);
+  }
+  size_t offset = r->head;
+  if (offset + size > REWIND_BUFFER_SIZE) {
+    // The frames between the head and the end are the oldest - they go
+    // before anything at the start is overwritten
+    while (r->oldest < r->next &&
+           r->frames[r->oldest % REWIND_MAX_FRAMES].offset >= offset) {
+      rewind_evict_oldest(r);
+    }
+    offset = 0;
+  }
+  while (r->oldest < r->next &&
+         rewind_overlaps(&r->frames[r->oldest % REWIND_MAX_FRAMES], offset,
+                         size)) {
+    rewind_evict_oldest(r);
+  }
+  // deltas whose keyframe just went are no use
+  while (r->oldest < r->next &&
+         r->frames[r->oldest % REWIND_MAX_FRAMES].keyframe != r->oldest) {
+    rewind_evict_oldest(r);
+  }
+  return offset;
+}
+
+// Once per tick, after the simulation
+void CaptureRewind(Rewind *r, World *world) {
+  if (!r->recording) {
+    return;
+  }
+  uint64_t start = stream_now_ns();
+  size_t size = rewind_pack(world, r->packed);
+  if (size == 0) {
+    return;
+  }
+
+  uint64_t seq = r->next;
+  uint64_t keyframe =
+      r->next > r->oldest ? r->frames[(seq - 1) % REWIND_MAX_FRAMES].keyframe
+                          : seq;
+  bool isKeyframe = r->keySize == 0 || keyframe < r->oldest ||
+                    seq - keyframe >= REWIND_KEYFRAME_INTERVAL;
+  if (isKeyframe) {
+    keyframe = seq;
+    memcpy(r->key, r->packed, size);
+    r->keySize = size;
+  } else {
+    size_t common = size < r->keySize ? size : r->keySize;
+    for (size_t i = 0; i < common; i++) {
+      r->packed[i] ^= r->key[i];
+    }
+  }
+
+  size_t encodedSize = lz_compress(r->packed, size, r->encoded,
+                                   lz_compress_bound(r->rawCapacity));
+  if (encodedSize > REWIND_BUFFER_SIZE / 4) {
+    r->keySize = 0; // would crowd out everything else - start again
+    return;
+  }
+  size_t offset = rewind_reserve(r, encodedSize);
+  if (keyframe < r->oldest) {
+    r->keySize = 0; // the room it needed took its keyframe
+    return;
+  }
+  r->head = offset + encodedSize;
+  memcpy(r->buffer + offset, r->encoded, encodedSize);
+  r->frames[seq % REWIND_MAX_FRAMES] =
+      (RewindFrame){offset, encodedSize, size, keyframe};
+  r->next++;
+  r->bytesUsed += encodedSize;
+  r->rawBytes += size;
+  r->captureNs = stream_now_ns() - start;
+}
+
+// Puts the World back as it was at frame seq
+bool RestoreRewind(Rewind *r, World *world, uint64_t seq) {
+  if (seq < r->oldest || seq >= r->next) {
+    return false;
+  }
+  RewindFrame *frame = &r->frames[seq % REWIND_MAX_FRAMES];
+  RewindFrame *key = &r->frames[frame->keyframe % REWIND_MAX_FRAMES];
+  if (!lz_decompress(r->buffer + key->offset, key->size, r->decoded,
+                     key->rawSize)) {
+    return false;
+  }
+  if (frame != key) {
+    if (!lz_decompress(r->buffer + frame->offset, frame->size, r->packed,
+                       frame->rawSize)) {
+      return false;
+    }
+    size_t common =
+        frame->rawSize < key->rawSize ? frame->rawSize : key->rawSize;
+    for (size_t i = 0; i < common; i++) {
+      r->packed[i] ^= r->decoded[i];
+    }
+    rewind_unpack(world, r->packed);
+  } else {
+    rewind_unpack(world, r->decoded);
+  }
+  return true;
+}
+
+// Freezes the World at the newest frame, restored so that it's in the
+// same state as any other frame. Returns false if there's none.
+bool BeginRewind(Rewind *r, World *world) {
+  if (r->next == r->oldest || !RestoreRewind(r, world, r->next - 1)) {
+    return false;
+  }
+  r->scrubbing = true;
+  r->cursor = r->next - 1;
+  return true;
+}
+
+// Moves the frame shown by step frames, stopping at either end
+void ScrubRewind(Rewind *r, World *world, int step) {
+  int64_t cursor = (int64_t)r->cursor + step;
+  if (cursor < (int64_t)r->oldest) {
+    cursor = r->oldest;
+  }
+  if (cursor >= (int64_t)r->next) {
+    cursor = r->next - 1;
+  }
+  if ((uint64_t)cursor != r->cursor && RestoreRewind(r, world, cursor)) {
+    r->cursor = cursor;
+  }
+}
+
+// Carries on from the frame shown - the frames after it are dropped
+void EndRewind(Rewind *r) {
+  while (r->next > r->cursor + 1) {
+    r->next--;
+    RewindFrame *frame = &r->frames[r->next % REWIND_MAX_FRAMES];
+    r->bytesUsed -= frame->size;
+    r->rawBytes -= frame->rawSize;
+  }
+  RewindFrame *frame = &r->frames[r->cursor % REWIND_MAX_FRAMES];
+  r->head = frame->offset + frame->size;
+  r->keySize = 0; // the stored key may be one that was dropped
+  r->scrubbing = false;
+}
@@ -0,0 +1,271 @@
+//
+// Save files
+//
+// A save is a header, a section table, then each section 64-byte aligned:
+//
+//   SaveHeader | SaveSection[sectionCount] | world | chunks
+//
+// The World is plain data, so its section is the struct's bytes as they
+// are in memory and the chunk section is the ChunkTable's entry array.
+// Loading maps the file copy-on-write and points the World at it - nothing
+// is parsed or copied, pages come in as they're touched. The few pointers
+// are written as 0 and fixed up on load (see save_fixup_world).
+//
+// The layout is native (same byte order and struct layout as the build
+// that wrote it), so the header records the sizes it was written with and
+// SAVE_VERSION has to go up whenever World or what a section's bytes mean
+// changes - 2 added ChunkInfo.unsaved to the chunk entries.
+//
+
+#include <errno.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SAVE_MAGIC "FTTSAVE"
+#define SAVE_VERSION 2
+#define SAVE_ALIGNMENT 64
+#define SAVE_PATH "world.sav"
+
+typedef enum SaveSectionId {
+  save_section_nil = 0,
+  save_section_world,
+  save_section_chunks,
+  SAVE_SECTION_MAX
+} SaveSectionId;
+
+typedef struct SaveHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t sectionCount;
+  uint64_t fileSize;
+  // what the World section was written with
+  uint32_t worldSize;
+  uint32_t maxEntityCount;
+  int32_t playerIndex;
+  uint32_t chunkCapacity; // entries in the chunk section, a power of two
+} SaveHeader;
+
+typedef struct SaveSection {
+  uint32_t id; // SaveSectionId
+  uint32_t reserved;
+  uint64_t offset; // from the start of the file
+  uint64_t size;
+} SaveSection;
+
+// The file the current World lives in, if it was loaded
+typedef struct SaveMapping {
+  void *base;
+  size_t size;
+} SaveMapping;
+
+SaveMapping loadedSave = {0};
+
+bool save_write_all(int fd, const void *data, size_t size) {
+  const unsigned char *bytes = data;
+  while (size > 0) {
+    ssize_t written = write(fd, bytes, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    bytes += written;
+    size -= written;
+  }
+  return true;
+}
+
+bool save_write_padding(int fd, size_t offset) {
+  static const unsigned char zeros[SAVE_ALIGNMENT] = {0};
+  size_t padding = align_forward(offset, SAVE_ALIGNMENT) - offset;
+  return save_write_all(fd, zeros, padding);
+}
+
+// The World's bytes with its pointers written as 0. Written in pieces
+// around the two pointer fields (player comes first in World) so the
+// caller's World is only ever read.
+bool save_write_world(int fd, const World *world) {
+  static const unsigned char zeros[sizeof(ChunkTable)] = {0};
+  const unsigned char *bytes = (const unsigned char *)world;
+  size_t player = offsetof(World, player);
+  size_t afterPlayer = player + sizeof(world->player);
+  size_t chunks = offsetof(World, chunks);
+  size_t afterChunks = chunks + sizeof(world->chunks);
+  return save_write_all(fd, bytes, player) &&
+         save_write_all(fd, zeros, sizeof(world->player)) &&
+         save_write_all(fd, bytes + afterPlayer, chunks - afterPlayer) &&
+         save_write_all(fd, zeros, sizeof(world->chunks)) &&
+         save_write_all(fd, bytes + afterChunks, sizeof(World) - afterChunks);
+}
+
+// Writes to a temporary file and renames it over path, so a crash never
+// leaves half a save and a World mapped from the old file keeps its pages.
+// The temporary name has the process id in it, so a forked autosave and the
+// game never write the same one. scratch holds a copy of the chunk table
+// for the length of the call.
+bool SaveGame(const World *world, Arena *scratch, const char *path) {
+  // Chunks still being generated are saved as not there yet and the
+  // streamer's ChunkData doesn't go in the file
+  size_t chunkBytes = world->chunks.capacity * sizeof(ChunkTableEntry);
+  ChunkTableEntry *chunks = arena_alloc_nozero(scratch, chunkBytes);
+  if (!chunks && chunkBytes) {
+    return false;
+  }
+  memcpy(chunks, world->chunks.entries, chunkBytes);
+  for (size_t i = 0; i < world->chunks.capacity; i++) {
+    chunks[i].value.data = NULL;
+    if (chunks[i].value.state == chunk_requested) {
+      chunks[i].value.state = chunk_unloaded;
+    }
+  }
+
+  SaveHeader header = {
+      .magic = SAVE_MAGIC,
+      .version = SAVE_VERSION,
+      .sectionCount = SAVE_SECTION_MAX - 1,
+      .worldSize = sizeof(World),
+      .maxEntityCount = MAX_ENTITY_COUNT,
+      .playerIndex = (int32_t)(world->player - world->entities),
+      .chunkCapacity = (uint32_t)world->chunks.capacity,
+  };
+  SaveSection sections[SAVE_SECTION_MAX - 1];
+  size_t offset = sizeof(header) + sizeof(sections);
+  size_t sizes[SAVE_SECTION_MAX] = {
+      [save_section_world] = sizeof(World),
+      [save_section_chunks] = chunkBytes,
+  };
+  for (int id = 1; id < SAVE_SECTION_MAX; id++) {
+    offset = align_forward(offset, SAVE_ALIGNMENT);
+    sections[id - 1] = (SaveSection){id, 0, offset, sizes[id]};
+    offset += sizes[id];
+  }
+  header.fileSize = offset;
+
+  char tempPath[256];
+  snprintf(tempPath, sizeof(tempPath), "%s.%d.tmp", path, (int)getpid());
+  int fd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+
+  bool ok = save_write_all(fd, &header, sizeof(header)) &&
+            save_write_all(fd, sections, sizeof(sections));
+  offset = sizeof(header) + sizeof(sections);
+  for (int id = 1; ok && id < SAVE_SECTION_MAX; id++) {
+    ok = save_write_padding(fd, offset);
+    if (ok && id == save_section_world) {
+      // the pointers are meaningless in another run - written as 0
+      ok = save_write_world(fd, world);
+    } else if (ok) {
+      ok = save_write_all(fd, chunks, sizes[id]);
+    }
+    offset = sections[id - 1].offset + sizes[id];
+  }
+
+  ok = close(fd) == 0 && ok;
+  if (ok) {
+    ok = rename(tempPath, path) == 0;
+  }
+  if (!ok) {
+    unlink(tempPath);
+  }
+  return ok;
+}
+
+SaveSection *save_find_section(SaveHeader *header, SaveSectionId id) {
+  SaveSection *sections = (SaveSection *)(header + 1);
+  for (uint32_t i = 0; i < header->sectionCount; i++) {
+    SaveSection *section = &sections[i];
+    if (section->id == (uint32_t)id && section->offset % SAVE_ALIGNMENT == 0 &&
+        section->offset <= header->fileSize &&
+        section->size <= header->fileSize - section->offset) {
+      return section;
+    }
+  }
+  return NULL;
+}
+
+// Points the World's pointers back into this run's memory
+void save_fixup_world(World *loaded, SaveHeader *header, void *chunkEntries,
+                      Arena *session) {
+  loaded->player = &loaded->entities[header->playerIndex];
+  loaded->chunks.entries = chunkEntries;
+  loaded->chunks.capacity = header->chunkCapacity;
+  loaded->chunks.count = 0;
+  for (size_t i = 0; i < header->chunkCapacity; i++) {
+    loaded->chunks.count += loaded->chunks.entries[i].hash != 0;
+  }
+  loaded->chunks.arena = session;
+  // nothing the renderer has cached belongs to this World
+  loaded->dirtyChunkCount = 0;
+  loaded->allChunksDirty = true;
+}
+
+void ReleaseLoadedSave() {
+  if (loadedSave.base) {
+    munmap(loadedSave.base, loadedSave.size);
+  }
+  loadedSave = (SaveMapping){0};
+}
+
+// Replaces the current World with the one saved at path, like StartSession.
+// Returns NULL and leaves the current World alone if the file isn't a save
+// this build can read.
+World *LoadGame(GameMemory *memory, const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat info;
+  void *base = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(SaveHeader)) {
+    // Private and writable - the World is changed in place once loaded and
+    // those pages are copied, never written back
+    base = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                0);
+  }
+  close(fd);
+  if (base == MAP_FAILED) {
+    return NULL;
+  }
+
+  size_t size = info.st_size;
+  SaveHeader *header = base;
+  SaveSection *worldSection = NULL;
+  SaveSection *chunkSection = NULL;
+  bool ok = memcmp(header->magic, SAVE_MAGIC, sizeof(header->magic)) == 0 &&
+            header->version == SAVE_VERSION && header->fileSize == size &&
+            header->sectionCount <= SAVE_SECTION_MAX &&
+            sizeof(SaveHeader) + header->sectionCount * sizeof(SaveSection) <=
+                size &&
+            header->worldSize == sizeof(World) &&
+            header->maxEntityCount == MAX_ENTITY_COUNT &&
+            header->playerIndex >= 0 &&
+            header->playerIndex < MAX_ENTITY_COUNT &&
+            header->chunkCapacity > 0 &&
+            is_power_of_two(header->chunkCapacity);
+  if (ok) {
+    worldSection = save_find_section(header, save_section_world);
+    chunkSection = save_find_section(header, save_section_chunks);
+    ok = worldSection && worldSection->size == sizeof(World) && chunkSection &&
+         chunkSection->size ==
+             header->chunkCapacity * sizeof(ChunkTableEntry);
+  }
+  if (!ok) {
+    fprintf(stderr, "save: %s isn't a save this build can load\n", path);
+    munmap(base, size);
+    return NULL;
+  }
+
+  arena_free_all(&memory->session);
+  ReleaseLoadedSave();
+  loadedSave = (SaveMapping){base, size};
+  world = (World *)((unsigned char *)base + worldSection->offset);
+  save_fixup_world(world, header,
+                   (unsigned char *)base + chunkSection->offset,
+                   &memory->session);
+  return world;
+}
@@ -0,0 +1,303 @@
+//
+// Chunk streaming
+//
+// A worker thread generates chunks ahead of the player so the game thread
+// never pays for the noise. The two threads talk through a pair of
+// SpscQueues: the game thread sends ChunkData blocks with a coordinate
+// filled in, and the worker sends them back generated. The worker keeps its
+// own list of outstanding requests and always takes the one nearest the
+// focus - where the player will be a moment from now, going by the camera's
+// velocity - so turning around reprioritizes what's already queued.
+// Finished chunks are spawned into the World within a time budget per
+// frame, and chunks left far behind are unloaded.
+//
+// Chunks are only ever generated. A loaded save (save.c) already has its
+// chunks' entities in the World and marks them loaded, so they're left as
+// they are and only unloaded like any other.
+//
+
+#define STREAM_LOAD_RADIUS 2   // chunks around the focus kept loaded - 5x5
+#define STREAM_UNLOAD_RADIUS 4 // chunks this far from the player go
+#define STREAM_MAX_CHUNKS 128  // ChunkData blocks, loaded plus in flight
+#define STREAM_MAX_UNLOADS 16  // per frame
+
+const float streamLookaheadSeconds = 1.0f;
+const int streamIntegrateBudgetUs = 1000; // per frame
+const long streamIdleSleepNs = 1000000;
+
+POOL_DEFINE(ChunkData, ChunkDataPool, chunk_data_pool)
+
+typedef struct Streamer {
+  // Game thread only
+  ChunkDataPool chunks;
+  Vector2 lastCameraTarget;
+  int inFlight; // with the worker or waiting in results
+  int loaded;   // spawned chunks still holding their ChunkData
+  uint64_t integrateNs; // spent spawning chunks last frame
+  // totals
+  int spawned;
+  int dropped; // came back cancelled or after they stopped being wanted
+  int unloaded;
+  bool running;         // false if the thread couldn't start
+  pthread_t thread;
+  // Shared
+  SpscQueue requests; // game thread -> worker
+  SpscQueue results;  // worker -> game thread
+  uint64_t focus;     // packed Vector2 - __atomic builtins only
+  uint32_t session;   // bumped per new World - written by the game thread
+  int quit;           // __atomic builtins only
+} Streamer;
+
+uint64_t stream_now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void stream_store_focus(Streamer *s, Vector2 focus) {
+  uint64_t packed;
+  memcpy(&packed, &focus, sizeof(packed));
+  __atomic_store_n(&s->focus, packed, __ATOMIC_RELAXED);
+}
+
+Vector2 stream_load_focus(Streamer *s) {
+  uint64_t packed = __atomic_load_n(&s->focus, __ATOMIC_RELAXED);
+  Vector2 focus;
+  memcpy(&focus, &packed, sizeof(focus));
+  return focus;
+}
+
+// In chunks - the square radius the load and unload rings use
+int chunk_ring_distance(ChunkCoord a, ChunkCoord b) {
+  int dx = abs(a.x - b.x);
+  int dy = abs(a.y - b.y);
+  return dx > dy ? dx : dy;
+}
+
+float chunk_center_distance(ChunkCoord coord, Vector2 pos) {
+  Vector2 center = {(coord.x + 0.5f) * chunkWidth,
+                    (coord.y + 0.5f) * chunkWidth};
+  return Vector2Distance(center, pos);
+}
+
+void *stream_worker(void *arg) {
+  Streamer *s = arg;
+  ChunkData *pending[STREAM_MAX_CHUNKS];
+  int count = 0;
+  struct timespec idle = {0, streamIdleSleepNs};
+
+  while (!__atomic_load_n(&s->quit, __ATOMIC_ACQUIRE)) {
+    ChunkData *request;
+    while (count < STREAM_MAX_CHUNKS &&
+           (request = spsc_queue_pop(&s->requests))) {
+      pending[count++] = request;
+    }
+    if (count == 0) {
+      nanosleep(&idle, NULL);
+      continue;
+    }
+
+    Vector2 focus = stream_load_focus(s);
+    int best = 0;
+    float bestDistance = chunk_center_distance(pending[0]->coord, focus);
+    for (int i = 1; i < count; i++) {
+      float distance = chunk_center_distance(pending[i]->coord, focus);
+      if (distance < bestDistance) {
+        best = i;
+        bestDistance = distance;
+      }
+    }
+    ChunkData *data = pending[best];
+    pending[best] = pending[--count];
+
+    // Not worth generating if it'd be unloaded as soon as it arrived
+    uint32_t session = __atomic_load_n(&s->session, __ATOMIC_RELAXED);
+    data->cancelled =
+        data->session != session ||
+        chunk_ring_distance(data->coord, chunk_of(focus)) >
+            STREAM_UNLOAD_RADIUS;
+    if (!data->cancelled) {
+      GenerateChunkData(data);
+    }
+    // Never full - it holds every block there is
+    spsc_queue_push(&s->results, data);
+  }
+  return NULL;
+}
+
+// Starts the worker. If the thread can't be started UpdateStreaming falls
+// back to generating on the game thread.
+bool InitStreamer(Streamer *s, Arena *arena) {
+  memset(s, 0, sizeof(*s));
+  if (!chunk_data_pool_init(&s->chunks, arena, STREAM_MAX_CHUNKS, true) ||
+      !spsc_queue_init(&s->requests, arena, STREAM_MAX_CHUNKS) ||
+      !spsc_queue_init(&s->results, arena, STREAM_MAX_CHUNKS)) {
+    return false;
+  }
+  s->running = pthread_create(&s->thread, NULL, stream_worker, s) == 0;
+  if (!s->running) {
+    fprintf(stderr, "streaming: no worker thread, generating inline\n");
+  }
+  return true;
+}
+
+void UnloadStreamer(Streamer *s) {
+  if (s->running) {
+    __atomic_store_n(&s->quit, 1, __ATOMIC_RELEASE);
+    pthread_join(s->thread, NULL);
+    s->running = false;
+  }
+}
+
+// Call after StartSession - everything streamed belongs to the old World.
+// Blocks still with the worker are dropped when they come back.
+void ResetStreamer(Streamer *s, World *world) {
+  __atomic_store_n(&s->session, s->session + 1, __ATOMIC_RELAXED);
+  Pool *pool = &s->chunks.pool;
+  for (long i = pool_next_occupied(pool, 0); i >= 0;
+       i = pool_next_occupied(pool, i + 1)) {
+    ChunkData *data = chunk_data_pool_at(&s->chunks, i);
+    if (!data->inFlight) {
+      chunk_data_pool_free(&s->chunks, data);
+    }
+  }
+  s->loaded = 0;
+  s->lastCameraTarget = world->camera.target;
+}
+
+// Spawns finished chunks until the frame's budget is spent
+void stream_integrate(Streamer *s, World *world) {
+  uint64_t start = stream_now_ns();
+  uint64_t budget = (uint64_t)streamIntegrateBudgetUs * 1000;
+  ChunkData *data;
+  while ((data = spsc_queue_pop(&s->results))) {
+    data->inFlight = false;
+    s->inFlight--;
+    ChunkInfo *info = data->session == s->session
+                          ? chunk_table_get(&world->chunks, data->coord)
+                          : NULL;
+    if (info && info->state == chunk_requested && !data->cancelled) {
+      SpawnChunkData(world, data);
+      info->state = chunk_loaded;
+      info->data = data;
+      s->loaded++;
+      s->spawned++;
+    } else {
+      if (info && info->state == chunk_requested) {
+        // requested again if it's still wanted
+        chunk_table_remove(&world->chunks, data->coord);
+      }
+      chunk_data_pool_free(&s->chunks, data);
+      s->dropped++;
+    }
+    if (stream_now_ns() - start > budget) {
+      break;
+    }
+  }
+  s->integrateNs = stream_now_ns() - start;
+}
+
+void stream_request(Streamer *s, World *world, Vector2 focus) {
+  ChunkCoord center = chunk_of(focus);
+  for (int dy = -STREAM_LOAD_RADIUS; dy <= STREAM_LOAD_RADIUS; dy++) {
+    for (int dx = -STREAM_LOAD_RADIUS; dx <= STREAM_LOAD_RADIUS; dx++) {
+      ChunkCoord coord = {center.x + dx, center.y + dy};
+      ChunkInfo *info = chunk_table_put(&world->chunks, coord);
+      if (!info) {
+        return; // out of session memory
+      }
+      if (info->state != chunk_unloaded) {
+        continue;
+      }
+      ChunkData *data = chunk_data_pool_alloc(&s->chunks);
+      if (!data) {
+        // every block is in use - the unload ring frees some up
+        chunk_table_remove(&world->chunks, coord);
+        return;
+      }
+      data->coord = coord;
+      data->seed = world->seed;
+      data->session = s->session;
+      data->inFlight = true;
+      spsc_queue_push(&s->requests, data);
+      info->state = chunk_requested;
+      s->inFlight++;
+    }
+  }
+}
+
+// Destroys what was spawned in chunks far from the player. Chunks the
+// player changed keep their entities - they'd come back as new if
+// regenerated - but give their ChunkData back, or enough of them would hold
+// every block and nothing new could stream in. The ground falls back to
+// noise for a chunk without data.
+void stream_unload(Streamer *s, World *world) {
+  ChunkCoord center = chunk_of(world->player->pos);
+  ChunkCoord unload[STREAM_MAX_UNLOADS];
+  int count = 0;
+  for (size_t i = 0; i < world->chunks.capacity && count < STREAM_MAX_UNLOADS;
+       i++) {
+    ChunkTableEntry *entry = &world->chunks.entries[i];
+    if (!entry->hash || entry->value.state != chunk_loaded ||
+        chunk_ring_distance(entry->key, center) <= STREAM_UNLOAD_RADIUS) {
+      continue;
+    }
+    if (!entry->value.modified) {
+      unload[count++] = entry->key;
+    } else if (entry->value.data) {
+      chunk_data_pool_free(&s->chunks, entry->value.data);
+      entry->value.data = NULL;
+      s->loaded--;
+    }
+  }
+  if (count == 0) {
+    return;
+  }
+
+  for (int i = 0; i < world->entityHighWater; i++) {
+    Entity *entity = &world->entities[i];
+    if (!entity->is_valid || entity == world->player) {
+      continue;
+    }
+    ChunkCoord coord = entity_chunk(entity);
+    for (int c = 0; c < count; c++) {
+      if (chunk_coord_eq(coord, unload[c])) {
+        entity_destroy(entity);
+        break;
+      }
+    }
+  }
+  for (int c = 0; c < count; c++) {
+    ChunkInfo *info = chunk_table_get(&world->chunks, unload[c]);
+    if (info->data) {
+      chunk_data_pool_free(&s->chunks, info->data);
+      s->loaded--;
+    }
+    chunk_table_remove(&world->chunks, unload[c]);
+    s->unloaded++;
+  }
+}
+
+// Once per tick, before anything looks at the World's entities
+void UpdateStreaming(Streamer *s, World *world, float deltaT) {
+  if (!s->running) {
+    UpdateWorldGen(world);
+    stream_unload(s, world);
+    return;
+  }
+
+  Vector2 velocity = {0};
+  if (deltaT > 0) {
+    velocity = Vector2Scale(
+        Vector2Subtract(world->camera.target, s->lastCameraTarget),
+        1.0f / deltaT);
+  }
+  s->lastCameraTarget = world->camera.target;
+  Vector2 focus = Vector2Add(world->player->pos,
+                             Vector2Scale(velocity, streamLookaheadSeconds));
+  stream_store_focus(s, focus);
+
+  stream_integrate(s, world);
+  stream_request(s, world, focus);
+  stream_unload(s, world);
+}
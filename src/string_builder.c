@@ -0,0 +1,93 @@
+//
+// String builder for multi-part UI text
+//
+// Appends into a buffer grown through arena_resize, so while it is the
+// arena's latest allocation every append is an in-place bump. Build it in
+// the frame arena and let the frame reset throw it away.
+//
+
+typedef struct StringBuilder {
+  Arena *arena;
+  ArenaTag tag;
+  char *data; // always NUL terminated once initialised
+  size_t length;
+  size_t capacity;
+} StringBuilder;
+
+bool sb_reserve(StringBuilder *sb, size_t capacity) {
+  if (capacity <= sb->capacity) {
+    return true;
+  }
+  size_t new_capacity = sb->capacity ? sb->capacity * 2 : 32;
+  while (new_capacity < capacity) {
+    new_capacity *= 2;
+  }
+  char *data = arena_resize_align_flags(sb->arena, sb->data, sb->capacity,
+                                        new_capacity, 1, arena_flag_no_zero);
+  if (!data) {
+    return false;
+  }
+  sb->data = data;
+  sb->capacity = new_capacity;
+  return true;
+}
+
+bool sb_init(StringBuilder *sb, Arena *arena, ArenaTag tag, size_t capacity) {
+  memset(sb, 0, sizeof(*sb));
+  sb->arena = arena;
+  sb->tag = tag;
+  sb->data = arena_alloc_align_flags(arena, capacity ? capacity : 32, 1, tag,
+                                     arena_flag_no_zero);
+  if (!sb->data) {
+    return false;
+  }
+  sb->capacity = capacity ? capacity : 32;
+  sb->data[0] = 0;
+  return true;
+}
+
+bool sb_append_len(StringBuilder *sb, const char *str, size_t len) {
+  if (!sb_reserve(sb, sb->length + len + 1)) {
+    return false;
+  }
+  memcpy(sb->data + sb->length, str, len);
+  sb->length += len;
+  sb->data[sb->length] = 0;
+  return true;
+}
+
+bool sb_append(StringBuilder *sb, const char *str) {
+  return sb_append_len(sb, str, strlen(str));
+}
+
+bool sb_appendf(StringBuilder *sb, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+bool sb_appendf(StringBuilder *sb, const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  size_t avail = sb->capacity - sb->length;
+  int length = vsnprintf(sb->data + sb->length, avail, fmt, args);
+  va_end(args);
+  if (length < 0) {
+    sb->data[sb->length] = 0;
+    return false;
+  }
+
+  if ((size_t)length >= avail) {
+    // Didn't fit - grow to the measured size and format again
+    if (!sb_reserve(sb, sb->length + length + 1)) {
+      sb->data[sb->length] = 0;
+      return false;
+    }
+    va_start(args, fmt);
+    vsnprintf(sb->data + sb->length, length + 1, fmt, args);
+    va_end(args);
+  }
+  sb->length += length;
+  return true;
+}
+
+void sb_clear(StringBuilder *sb) {
+  sb->length = 0;
+  sb->data[0] = 0;
+}
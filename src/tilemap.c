@@ -0,0 +1,213 @@
+//
+// Ground tile map
+//
+// Every tile of the ground has a GroundTile index, worked out from the
+// World's seed with noise so any tile of the unbounded map can be looked up
+// on its own. The renderer uploads the indices around the camera as a
+// one-byte-per-tile texture and a fragment shader turns each pixel into a
+// texel of the tileset (see render.c). Everything in this file is plain C
+// so the headless bench can run the same lookup on the CPU -
+// RenderGroundCPU is the reference the shader has to match.
+//
+
+typedef enum GroundTile {
+  ground_grass = 0,
+  ground_grass_tall,
+  ground_flowers,
+  ground_dirt,
+  ground_water,
+  GROUND_TILE_MAX
+} GroundTile;
+
+// One tileset texel per sprite pixel
+#define GROUND_TILE_TEXELS 10 // TILE_WIDTH / spriteScale
+
+// Chunks of indices kept around the camera chunk - 3x3 always covers the
+// screen as long as half the view is narrower than a chunk
+#define GROUND_WINDOW_CHUNKS 3
+#define GROUND_WINDOW_TILES (GROUND_WINDOW_CHUNKS * CHUNK_TILES)
+
+uint32_t ground_hash(int x, int y, uint32_t salt) {
+  return hash_u64(((uint64_t)(uint32_t)x << 32 | (uint32_t)y) ^
+                  ((uint64_t)salt << 17));
+}
+
+// Noise salts so each layer of terrain is independent of the others
+#define GROUND_SALT_STREAM 0x5157
+#define GROUND_SALT_DIRT 0xd127
+
+// Streams follow the 0.5 contour of a low frequency noise field - a thin
+// band of it winds like a river and never ends at a chunk edge
+const float groundStreamScale = 1.0f / 48;
+const float groundStreamWidth = 0.014f;
+// Dirt comes in patches where a finer field is high
+const float groundDirtScale = 1.0f / 10;
+const float groundDirtThreshold = 0.68f;
+
+#define GROUND_STREAM_OCTAVES 3
+#define GROUND_DIRT_OCTAVES 2
+#define GROUND_ROW_BATCH 64
+
+// The tile given its two noise samples
+GroundTile ground_tile_from(uint32_t seed, int tileX, int tileY, float stream,
+                            float dirt) {
+  if (fabsf(stream - 0.5f) < groundStreamWidth) {
+    return ground_water;
+  }
+  if (dirt > groundDirtThreshold) {
+    return ground_dirt;
+  }
+  uint32_t roll = ground_hash(tileX, tileY, seed) % 100;
+  if (roll < 10) {
+    return ground_grass_tall;
+  }
+  if (roll < 14) {
+    return ground_flowers;
+  }
+  return ground_grass;
+}
+
+GroundTile GroundTileAt(uint32_t seed, int tileX, int tileY) {
+  float stream = fbm_noise(seed ^ GROUND_SALT_STREAM,
+                           tileX * groundStreamScale,
+                           tileY * groundStreamScale, GROUND_STREAM_OCTAVES);
+  float dirt = fbm_noise(seed ^ GROUND_SALT_DIRT, tileX * groundDirtScale,
+                         tileY * groundDirtScale, GROUND_DIRT_OCTAVES);
+  return ground_tile_from(seed, tileX, tileY, stream, dirt);
+}
+
+// Same as GroundTileAt for count tiles along a row, with the noise sampled
+// a vector at a time
+void GroundTileRow(uint32_t seed, int tileX, int tileY, int count,
+                   unsigned char *out) {
+  float stream[GROUND_ROW_BATCH];
+  float dirt[GROUND_ROW_BATCH];
+  for (int start = 0; start < count; start += GROUND_ROW_BATCH) {
+    int batch = count - start < GROUND_ROW_BATCH ? count - start
+                                                  : GROUND_ROW_BATCH;
+    int x = tileX + start;
+    fbm_noise_row(seed ^ GROUND_SALT_STREAM, x, tileY, groundStreamScale,
+                  batch, GROUND_STREAM_OCTAVES, stream);
+    fbm_noise_row(seed ^ GROUND_SALT_DIRT, x, tileY, groundDirtScale, batch,
+                  GROUND_DIRT_OCTAVES, dirt);
+    for (int i = 0; i < batch; i++) {
+      out[start + i] =
+          ground_tile_from(seed, x + i, tileY, stream[i], dirt[i]);
+    }
+  }
+}
+
+// Procedural tileset - x, y are texels within the tile
+Color GroundTilesetTexel(GroundTile tile, int x, int y) {
+  Color grass = {0x4b, 0x69, 0x2f, 0xff}; // the old background colour
+  Color dark = {0x3f, 0x5a, 0x27, 0xff};
+  uint32_t speckle = ground_hash(x, y, 2 + tile) % 16;
+  switch (tile) {
+  case ground_grass_tall:
+    // two pixel blades on alternate columns
+    return (x % 3 == 1 && (y + x) % 5 < 2) ? dark : grass;
+  case ground_flowers:
+    if ((x == 2 && y == 3) || (x == 7 && y == 6)) {
+      return (Color){0xe8, 0xd4, 0x4d, 0xff};
+    }
+    if ((x == 5 && y == 1) || (x == 3 && y == 8)) {
+      return (Color){0xd9, 0x5b, 0x8e, 0xff};
+    }
+    return speckle == 0 ? dark : grass;
+  case ground_dirt:
+    return speckle < 3 ? (Color){0x6b, 0x4a, 0x2b, 0xff}
+                       : (Color){0x7d, 0x58, 0x35, 0xff};
+  case ground_water:
+    // short ripples staggered row to row
+    if (y % 4 == 1 && (x + y) % 7 < 3) {
+      return (Color){0x8f, 0xc4, 0xe0, 0xff};
+    }
+    return speckle < 2 ? (Color){0x2f, 0x6b, 0xa3, 0xff}
+                       : (Color){0x35, 0x78, 0xb5, 0xff};
+  default:
+    return speckle == 0 ? dark : grass;
+  }
+}
+
+// Fills a width x height block of indices whose top left is tile
+// (originX, originY). stride is the row length of out.
+void FillGroundIndices(unsigned char *out, int stride, uint32_t seed,
+                       int originX, int originY, int width, int height) {
+  for (int y = 0; y < height; y++) {
+    GroundTileRow(seed, originX, originY + y, width, &out[y * stride]);
+  }
+}
+
+// Window of indices centred on a chunk, filled a chunk at a time
+typedef struct GroundWindow {
+  unsigned char indices[GROUND_WINDOW_TILES * GROUND_WINDOW_TILES];
+  ChunkCoord center;
+  uint32_t seed;
+  int originX; // tile coords of indices[0]
+  int originY;
+  bool filled;
+} GroundWindow;
+
+// Returns true if the indices changed and need uploading. Chunks already
+// streamed in (see streaming.c) are copied from chunks rather than worked
+// out again - chunks can be NULL.
+bool UpdateGroundWindow(GroundWindow *window, uint32_t seed,
+                        ChunkCoord center, ChunkTable *chunks) {
+  if (window->filled && window->seed == seed &&
+      chunk_coord_eq(window->center, center)) {
+    return false;
+  }
+  window->center = center;
+  window->seed = seed;
+  window->originX = (center.x - GROUND_WINDOW_CHUNKS / 2) * CHUNK_TILES;
+  window->originY = (center.y - GROUND_WINDOW_CHUNKS / 2) * CHUNK_TILES;
+  for (int cy = 0; cy < GROUND_WINDOW_CHUNKS; cy++) {
+    for (int cx = 0; cx < GROUND_WINDOW_CHUNKS; cx++) {
+      int offset = cy * CHUNK_TILES * GROUND_WINDOW_TILES + cx * CHUNK_TILES;
+      ChunkCoord coord = {center.x - GROUND_WINDOW_CHUNKS / 2 + cx,
+                          center.y - GROUND_WINDOW_CHUNKS / 2 + cy};
+      ChunkInfo *info = chunks ? chunk_table_get(chunks, coord) : NULL;
+      if (info && info->data) {
+        for (int y = 0; y < CHUNK_TILES; y++) {
+          memcpy(&window->indices[offset + y * GROUND_WINDOW_TILES],
+                 &info->data->tiles[y * CHUNK_TILES], CHUNK_TILES);
+        }
+        continue;
+      }
+      FillGroundIndices(&window->indices[offset], GROUND_WINDOW_TILES, seed,
+                        window->originX + cx * CHUNK_TILES,
+                        window->originY + cy * CHUNK_TILES, CHUNK_TILES,
+                        CHUNK_TILES);
+    }
+  }
+  window->filled = true;
+  return true;
+}
+
+// CPU version of the ground shader. Draws the window into a width x height
+// buffer as seen through camera, sampling each pixel at its centre.
+// Pixels outside the window are left alone.
+void RenderGroundCPU(GroundWindow *window, Color *pixels, int width,
+                     int height, Camera2D camera) {
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      // inverse of the camera transform (rotation is always 0)
+      float worldX = (x + 0.5f - camera.offset.x) / camera.zoom +
+                     camera.target.x;
+      float worldY = (y + 0.5f - camera.offset.y) / camera.zoom +
+                     camera.target.y;
+      float tileX = worldX / tileWidth - window->originX;
+      float tileY = worldY / tileWidth - window->originY;
+      int cellX = (int)floorf(tileX);
+      int cellY = (int)floorf(tileY);
+      if (cellX < 0 || cellY < 0 || cellX >= GROUND_WINDOW_TILES ||
+          cellY >= GROUND_WINDOW_TILES) {
+        continue;
+      }
+      GroundTile tile = window->indices[cellY * GROUND_WINDOW_TILES + cellX];
+      int texelX = (int)((tileX - cellX) * GROUND_TILE_TEXELS);
+      int texelY = (int)((tileY - cellY) * GROUND_TILE_TEXELS);
+      pixels[y * width + x] = GroundTilesetTexel(tile, texelX, texelY);
+    }
+  }
+}
@@ -0,0 +1,781 @@
+//
+// Game Code - world state and simulation systems. Nothing in here may call
+// into raylib at runtime (only its types and raymath) so the headless
+// benchmark can link it without a window.
+//
+
+#include "raylib.h"
+#include "raymath.h"
+#include <math.h>
+
+typedef enum EntityArchetype {
+  arch_nil = 0,
+  arch_player,
+  arch_hoe,
+  arch_shovel,
+  arch_weed,
+  arch_rock,
+  arch_item_wood,
+  arch_item_plant_matter,
+  arch_item_stone,
+  arch_berry_bush,
+  arch_item_berry,
+  ARCH_MAX
+} EntityArchetype;
+char *getArchetypeName(EntityArchetype arch) {
+  switch (arch) {
+  case arch_player:
+    return "player";
+  case arch_hoe:
+    return "hoe";
+  case arch_shovel:
+    return "shovel";
+  case arch_weed:
+    return "weed";
+  case arch_rock:
+    return "rock";
+  case arch_item_wood:
+    return "item wood";
+  case arch_item_stone:
+    return "item stone";
+  case arch_item_plant_matter:
+    return "item plant matter";
+  case arch_berry_bush:
+    return "berry bush";
+  case arch_item_berry:
+    return "item berry";
+  default:
+    return "nil";
+  }
+};
+
+typedef enum SpriteId {
+  sprite_nil = 0,
+  sprite_player,
+  sprite_hoe,
+  sprite_shovel,
+  sprite_weed,
+  sprite_rock,
+  sprite_wood,
+  sprite_stone_material,
+  sprite_plant_material,
+  sprite_berries,
+  sprite_berry,
+  SPRITE_MAX
+} SpriteId;
+
+SpriteId getArchetypeSpriteId(EntityArchetype arch) {
+  switch (arch) {
+  case arch_player:
+    return sprite_player;
+  case arch_hoe:
+    return sprite_hoe;
+  case arch_shovel:
+    return sprite_shovel;
+  case arch_weed:
+    return sprite_weed;
+  case arch_rock:
+    return sprite_rock;
+  case arch_item_wood:
+    return sprite_wood;
+  case arch_item_stone:
+    return sprite_stone_material;
+  case arch_item_plant_matter:
+    return sprite_plant_material;
+  case arch_berry_bush:
+    return sprite_berries;
+  case arch_item_berry:
+    return sprite_berry;
+  default:
+    return sprite_nil;
+  }
+};
+
+char *spritePaths[SPRITE_MAX] = {
+    [sprite_nil] = "assets/sprites/nil_texture.png",
+    [sprite_player] = "assets/sprites/player.png",
+    [sprite_hoe] = "assets/sprites/hoe.png",
+    [sprite_shovel] = "assets/sprites/shovel.png",
+    [sprite_weed] = "assets/sprites/weed.png",
+    [sprite_rock] = "assets/sprites/rock.png",
+    [sprite_wood] = "assets/sprites/wood.png",
+    [sprite_stone_material] = "assets/sprites/stone_material.png",
+    [sprite_plant_material] = "assets/sprites/plant_material.png",
+    [sprite_berries] = "assets/sprites/Berries.png",
+    [sprite_berry] = "assets/sprites/Berry.png",
+};
+
+//
+// Sprite animation frames and clips
+//
+// Frames below SPRITE_MAX are the plain sprites. The rest are described in
+// animFrames and generated from a sprite when the atlas is built (there are
+// no hand drawn sheets yet). A clip is a run of consecutive frames played
+// in a loop.
+//
+
+typedef struct AnimFrame {
+  SpriteId sprite;
+  int8_t shear; // top row moved this many pixels right, fading to 0 at the
+                // bottom row
+  bool flipX;
+} AnimFrame;
+
+const AnimFrame animFrames[] = {
+    // weed sway
+    {sprite_weed, 0, false},
+    {sprite_weed, 1, false},
+    {sprite_weed, 0, false},
+    {sprite_weed, -1, false},
+    // player walking right, then the same facing left
+    {sprite_player, 0, false},
+    {sprite_player, 1, false},
+    {sprite_player, 0, true},
+    {sprite_player, -1, true},
+};
+#define ANIM_FRAME_COUNT (sizeof(animFrames) / sizeof(animFrames[0]))
+#define FRAME_MAX (SPRITE_MAX + ANIM_FRAME_COUNT)
+
+typedef enum AnimClipId {
+  clip_none = 0,
+  clip_weed_sway,
+  clip_player_walk_right,
+  clip_player_walk_left,
+  clip_player_idle_left,
+  CLIP_MAX
+} AnimClipId;
+
+typedef struct AnimClip {
+  uint16_t firstFrame;
+  uint8_t frameCount;
+  uint8_t fps;
+} AnimClip;
+
+const AnimClip animClips[CLIP_MAX] = {
+    [clip_weed_sway] = {SPRITE_MAX + 0, 4, 3},
+    [clip_player_walk_right] = {SPRITE_MAX + 4, 2, 8},
+    [clip_player_walk_left] = {SPRITE_MAX + 6, 2, 8},
+    [clip_player_idle_left] = {SPRITE_MAX + 6, 1, 1},
+};
+
+// Only width/height are filled in (by BuildAtlas) and read by the simulation
+// for entity bounds - the pixels are drawn from the atlas
+Texture2D sprites[SPRITE_MAX];
+Texture2D *get_sprite(SpriteId id) {
+  if (id >= 0 && id < SPRITE_MAX) {
+    return &sprites[id];
+  }
+  return &sprites[0];
+}
+
+typedef struct Entity {
+  EntityArchetype archetype;
+  Vector2 pos;
+  bool is_valid;
+  int health;
+  SpriteId sprite_id;
+  bool is_item;
+  bool is_destroyable_world_item;
+} Entity;
+
+typedef enum GameState {
+  state_nil = 0,
+  state_start,
+  state_pause,
+  state_play,
+  state_gameover,
+  STATE_MAX
+} GameState;
+
+// The world is split into square chunks of CHUNK_TILES x CHUNK_TILES tiles
+#define CHUNK_TILES 32
+#define MAX_DIRTY_CHUNKS 64
+typedef struct ChunkCoord {
+  int x;
+  int y;
+} ChunkCoord;
+
+bool chunk_coord_eq(ChunkCoord a, ChunkCoord b) {
+  return a.x == b.x && a.y == b.y;
+}
+
+uint32_t hash_chunk_coord(ChunkCoord c) {
+  return hash_u64((uint64_t)(uint32_t)c.x << 32 | (uint32_t)c.y);
+}
+
+typedef enum ChunkState {
+  chunk_unloaded = 0,
+  chunk_requested, // waiting on the streaming thread
+  chunk_loaded,    // its entities are in the World
+  CHUNK_STATE_MAX
+} ChunkState;
+
+// A generated chunk, made without touching the World so any thread can make
+// one (see worldgen.c) - its terrain and what to spawn on it
+typedef struct ChunkSpawn {
+  uint8_t archetype;
+  uint8_t x; // tile within the chunk
+  uint8_t y;
+} ChunkSpawn;
+
+typedef struct ChunkData {
+  ChunkCoord coord;
+  uint32_t seed;
+  uint32_t session; // see streaming.c
+  bool inFlight;    // see streaming.c
+  bool cancelled;   // see streaming.c
+  int spawnCount;
+  unsigned char tiles[CHUNK_TILES * CHUNK_TILES]; // GroundTile per tile
+  ChunkSpawn spawns[CHUNK_TILES * CHUNK_TILES];
+} ChunkData;
+
+// What the World knows about a chunk - only chunks that have come near the
+// player have an entry
+typedef struct ChunkInfo {
+  uint8_t state;
+  bool modified;   // changed by the player - can't be regenerated
+  bool unsaved;    // modified since the last autosave (autosave.c)
+  ChunkData *data; // the generated chunk while it's loaded, if streamed
+} ChunkInfo;
+
+HASHMAP_DEFINE(ChunkCoord, ChunkInfo, ChunkTable, chunk_table,
+               hash_chunk_coord, chunk_coord_eq)
+
+// The world is generated as it's explored, so this bounds how much of it
+// can be populated at once
+#ifndef MAX_ENTITY_COUNT
+#define MAX_ENTITY_COUNT 65536
+#endif
+#define MAX_INVENTORY_COUNT ARCH_MAX
+// Per-entity animation arrays are padded to whole vector lanes
+#define ANIM_ENTITY_COUNT ((MAX_ENTITY_COUNT + 7) / 8 * 8)
+typedef struct World {
+  Entity entities[MAX_ENTITY_COUNT];
+  int inventory[MAX_INVENTORY_COUNT];
+  int timeInMinutes;
+  double timeElapsed;
+  int dayCount;
+  float energy;
+  float hydration;
+  GameState state;
+  float screenHeight;
+  float screenWidth;
+  Entity *player;
+  int firstFreeEntity; // no free slot exists below this index
+  int entityHighWater; // no valid entity exists at or above this index
+  Color backgroundColor;
+  Camera2D camera;
+  // Item bob animation as a structure of arrays indexed like entities, so
+  // animation.c can update every entity in one vector pass
+  float bobAmplitude[ANIM_ENTITY_COUNT]; // 0 for anything that doesn't bob
+  float bobPhaseCos[ANIM_ENTITY_COUNT];
+  float bobPhaseSin[ANIM_ENTITY_COUNT];
+  float bobOffset[ANIM_ENTITY_COUNT]; // output - add to pos.y when drawing
+  // Sprite animation playback, also indexed like entities
+  double animClock;                       // seconds, advanced every tick
+  uint8_t animClip[ANIM_ENTITY_COUNT];    // clip_none draws sprite_id
+  float animStart[ANIM_ENTITY_COUNT];     // animClock when the clip started
+  uint16_t animFrame[ANIM_ENTITY_COUNT];  // output - the frame to draw
+  bool playerFacingLeft;
+  // Chunks whose static entities changed since the renderer last drained
+  // this list. Overflowing it just marks everything dirty.
+  ChunkCoord dirtyChunks[MAX_DIRTY_CHUNKS];
+  int dirtyChunkCount;
+  bool allChunksDirty;
+  // World generation - see worldgen.c
+  uint32_t seed;
+  ChunkTable chunks; // in the session arena
+} World;
+
+World *world = 0;
+
+Entity *entity_create() {
+  Entity *entity_found = 0;
+  for (int i = world->firstFreeEntity; i < MAX_ENTITY_COUNT; i++) {
+    Entity *existing_entity = &(world->entities[i]);
+    if (!existing_entity->is_valid) {
+      entity_found = existing_entity;
+      world->firstFreeEntity = i + 1;
+      if (i + 1 > world->entityHighWater) {
+        world->entityHighWater = i + 1;
+      }
+      break;
+    }
+  }
+  if (!entity_found) {
+    return NULL; // full - callers skip the spawn
+  }
+
+  memset(entity_found, 0, sizeof(Entity));
+  int index = entity_found - world->entities;
+  world->bobAmplitude[index] = 0;
+  world->bobPhaseCos[index] = 1;
+  world->bobPhaseSin[index] = 0;
+  world->bobOffset[index] = 0;
+  world->animClip[index] = clip_none;
+
+  entity_found->is_valid = true;
+  return entity_found;
+}
+
+bool entity_is_static(Entity *entity);
+void world_mark_chunk_dirty(Vector2 pos);
+void world_mark_chunk_unsaved(Entity *entity);
+
+void entity_destroy(Entity *entity) {
+  if (entity_is_static(entity)) {
+    world_mark_chunk_dirty(entity->pos);
+  }
+  world_mark_chunk_unsaved(entity);
+  entity->is_valid = false;
+  int index = entity - world->entities;
+  if (index < world->firstFreeEntity) {
+    world->firstFreeEntity = index;
+  }
+}
+
+#define TILE_WIDTH 40
+const float tileWidth = TILE_WIDTH;
+
+int world_pos_to_tile_pos(float world_pos) {
+  return roundf(world_pos / tileWidth);
+}
+
+float tile_pos_to_world_pos(int tile_pos) { return tileWidth * tile_pos; }
+
+Vector2 round_v2_to_tile(Vector2 v2) {
+  v2.x = tile_pos_to_world_pos(world_pos_to_tile_pos(v2.x));
+  v2.y = tile_pos_to_world_pos(world_pos_to_tile_pos(v2.y));
+  return v2;
+}
+
+const float chunkWidth = CHUNK_TILES * TILE_WIDTH;
+
+ChunkCoord chunk_of(Vector2 pos) {
+  return (ChunkCoord){(int)floorf(pos.x / chunkWidth),
+                      (int)floorf(pos.y / chunkWidth)};
+}
+
+// The chunk of the tile an entity was spawned on. The Setup functions move
+// entities 0 to half a tile right and 0 to half a tile up from the tile's
+// corner, so x / tileWidth lands in [tile, tile + 0.5] and y / tileWidth in
+// [tile - 0.5, tile]. Adding 0.25 to x and 0.75 to y puts both in the
+// middle half of the tile, and flooring gets the tile back.
+ChunkCoord entity_chunk(Entity *entity) {
+  int tileX = (int)floorf(entity->pos.x / tileWidth + 0.25f);
+  int tileY = (int)floorf(entity->pos.y / tileWidth + 0.75f);
+  return (ChunkCoord){(int)floorf((float)tileX / CHUNK_TILES),
+                      (int)floorf((float)tileY / CHUNK_TILES)};
+}
+
+// Chunks the player has changed are kept loaded - regenerating them would
+// undo the change
+void world_mark_chunk_modified(Entity *entity) {
+  if (!world->chunks.entries) {
+    return; // no generated world (the bench scenes)
+  }
+  ChunkInfo *info = chunk_table_get(&world->chunks, entity_chunk(entity));
+  if (info) {
+    info->modified = true;
+    info->unsaved = true;
+  }
+}
+
+// Only modified chunks are saved - the rest regenerate from the seed
+void world_mark_chunk_unsaved(Entity *entity) {
+  if (!world->chunks.entries || entity == world->player) {
+    return;
+  }
+  ChunkInfo *info = chunk_table_get(&world->chunks, entity_chunk(entity));
+  if (info && info->modified) {
+    info->unsaved = true;
+  }
+}
+
+// Static entities never move - renderers can cache them per chunk as long
+// as every spawn and destroy marks the chunk dirty
+bool entity_is_static(Entity *entity) {
+  int index = entity - world->entities;
+  return entity->is_destroyable_world_item &&
+         world->animClip[index] == clip_none;
+}
+
+void world_mark_chunk_dirty(Vector2 pos) {
+  if (world->allChunksDirty) {
+    return;
+  }
+  ChunkCoord coord = chunk_of(pos);
+  for (int i = 0; i < world->dirtyChunkCount; i++) {
+    if (chunk_coord_eq(world->dirtyChunks[i], coord)) {
+      return;
+    }
+  }
+  if (world->dirtyChunkCount == MAX_DIRTY_CHUNKS) {
+    world->allChunksDirty = true;
+    world->dirtyChunkCount = 0;
+    return;
+  }
+  world->dirtyChunks[world->dirtyChunkCount++] = coord;
+}
+
+const float spriteScale = 4.0;
+
+const float itemBobHeight = 10;
+const float itemBobRate = 5;
+
+// phase is in radians along the shared bob curve
+void entity_set_bob(Entity *entity, float amplitude, float phase) {
+  int index = entity - world->entities;
+  world->bobAmplitude[index] = amplitude;
+  world->bobPhaseCos[index] = cosf(phase);
+  world->bobPhaseSin[index] = sinf(phase);
+}
+
+// start is an offset into the clip in seconds, so neighbours can be out of
+// step with each other
+void entity_set_clip(Entity *entity, AnimClipId clip, float start) {
+  int index = entity - world->entities;
+  if (world->animClip[index] == clip) {
+    return;
+  }
+  world->animClip[index] = clip;
+  world->animStart[index] = world->animClock - start;
+  world->animFrame[index] = animClips[clip].firstFrame;
+}
+
+const int playerHealth = 5;
+const float playerPickupRadius = 20.0;
+const int rockHealth = 3;
+const int weedHealth = 2;
+const int berryBushHealth = 2;
+
+Entity *SetupPlayer(Vector2 pos) {
+  Entity *entity = entity_create();
+
+  entity->pos = round_v2_to_tile(pos);
+  entity->pos.y -= tileWidth * 0.5;
+  entity->health = playerHealth;
+  /* entity->pos.x -= tileWidth * 0.5; */
+
+  entity->archetype = arch_player;
+  entity->sprite_id = sprite_player;
+  return entity;
+}
+Camera2D SetupCamera(Vector2 initialPlayerPosition) {
+  Camera2D camera = {0};
+
+  camera.target = world->player->pos;
+  camera.offset =
+      (Vector2){world->screenWidth / 2.0f, world->screenHeight / 2.0f};
+  camera.rotation = 0.0f;
+  camera.zoom = 1.25f;
+
+  return camera;
+}
+
+void SetupRock(Vector2 pos) {
+  Entity *entity = entity_create();
+  if (!entity) {
+    return;
+  }
+
+  entity->pos = round_v2_to_tile(pos);
+  entity->pos.y -= tileWidth * 0.5;
+  /* entity->pos.x += tileWidth * 0.125; */
+  entity->health = rockHealth;
+  entity->is_destroyable_world_item = true;
+
+  entity->archetype = arch_rock;
+  entity->sprite_id = sprite_rock;
+  world_mark_chunk_dirty(entity->pos);
+}
+
+void SetupWeed(Vector2 pos) {
+  Entity *entity = entity_create();
+  if (!entity) {
+    return;
+  }
+
+  entity->pos = round_v2_to_tile(pos);
+  entity->pos.y -= tileWidth * 0.5;
+  entity->pos.x += tileWidth * 0.25;
+  entity->health = weedHealth;
+  entity->is_destroyable_world_item = true;
+
+  entity->archetype = arch_weed;
+  entity->sprite_id = sprite_weed;
+  // out of step with its neighbours so the field doesn't sway in unison
+  uint32_t seed = hash_u64((uint64_t)(entity - world->entities));
+  entity_set_clip(entity, clip_weed_sway, (seed % 1024) / 256.0f);
+  world_mark_chunk_dirty(entity->pos);
+}
+
+void SetupItemWood(Vector2 pos) {
+  Entity *entity = entity_create();
+  if (!entity) {
+    return;
+  }
+
+  entity->pos = round_v2_to_tile(pos);
+  entity->pos.y -= tileWidth * 0.5;
+  entity->pos.x += tileWidth * 0.5;
+
+  entity->is_item = true;
+  entity_set_bob(entity, itemBobHeight, 0);
+
+  entity->archetype = arch_item_wood;
+  entity->sprite_id = sprite_wood;
+  // dropped by the player, so part of what a save has to keep
+  world_mark_chunk_modified(entity);
+}
+
+void SetupBerryBush(Vector2 pos) {
+  Entity *entity = entity_create();
+  if (!entity) {
+    return;
+  }
+
+  entity->pos = round_v2_to_tile(pos);
+  entity->pos.y -= tileWidth * 0.25;
+  entity->pos.x += tileWidth * 0.125;
+  entity->health = berryBushHealth;
+  entity->is_destroyable_world_item = true;
+
+  entity->archetype = arch_berry_bush;
+  entity->sprite_id = sprite_berries;
+  world_mark_chunk_dirty(entity->pos);
+}
+
+void SetupItemBerry(Vector2 pos) {
+  Entity *entity = entity_create();
+  if (!entity) {
+    return;
+  }
+
+  entity->pos = round_v2_to_tile(pos);
+  entity->pos.y -= tileWidth * 0.25;
+  entity->pos.x += tileWidth * 0.5;
+
+  entity->is_item = true;
+  entity_set_bob(entity, itemBobHeight, 0);
+
+  entity->archetype = arch_item_berry;
+  entity->sprite_id = sprite_berry;
+  // see SetupItemWood
+  world_mark_chunk_modified(entity);
+}
+
+Vector2 v2(float x, float y) { return (Vector2){x, y}; }
+
+void UpdateCameraCenterSmoothFollow(Camera2D *camera, Entity *player,
+                                    float delta, int width, int height) {
+  static float minSpeed = 30;
+  static float minEffectLength = 5;
+  static float fractionSpeed = 0.9f;
+
+  camera->offset = (Vector2){width / 2.0f, height / 2.0f};
+  Vector2 diff = Vector2Subtract(player->pos, camera->target);
+  float length = Vector2Length(diff);
+
+  if (length > minEffectLength) {
+    float speed = fmaxf(fractionSpeed * length, minSpeed);
+    camera->target =
+        Vector2Add(camera->target, Vector2Scale(diff, speed * delta / length));
+  }
+}
+
+void InitWorld(World *world) {
+  world->state = state_start;
+  world->dayCount = 0;
+  world->timeElapsed = 0;
+  world->timeInMinutes = 720; // 12noon
+  world->energy = 100;
+  world->hydration = 100;
+  world->screenWidth = 1280;
+  world->screenHeight = 720;
+  world->backgroundColor = (Color){0x4b, 0x69, 0x2f, 0xff};
+  world->allChunksDirty = true; // nothing cached belongs to this world
+
+  Vector2 initialPlayerPosition = {world->screenWidth / 2.0f,
+                                   world->screenHeight / 2.0f};
+  world->player = SetupPlayer(initialPlayerPosition);
+  world->camera = SetupCamera(initialPlayerPosition);
+};
+
+//
+// Memory lifetimes - every allocation picks the arena it dies with instead
+// of pairing temp_arena_memory_begin/end by hand
+//
+
+// Address space only - pages get committed as each arena grows
+#define PERMANENT_ARENA_RESERVE_SIZE GB(1)
+#define SESSION_ARENA_RESERVE_SIZE GB(16)
+#define FRAME_ARENA_RESERVE_SIZE GB(1)
+
+typedef struct GameMemory {
+  Arena permanent; // until exit - caches, atlases
+  Arena session;   // reset on new game - World and anything it points to
+  Arena frame[2];  // per-frame scratch, double-buffered so last frame's
+                   // allocations are still readable this frame
+  int frameIndex;
+} GameMemory;
+
+bool InitGameMemory(GameMemory *memory) {
+  memset(memory, 0, sizeof(*memory));
+  if (!arena_init_reserve(&memory->permanent, PERMANENT_ARENA_RESERVE_SIZE) ||
+      !arena_init_reserve(&memory->session, SESSION_ARENA_RESERVE_SIZE) ||
+      !arena_init_reserve(&memory->frame[0], FRAME_ARENA_RESERVE_SIZE) ||
+      !arena_init_reserve(&memory->frame[1], FRAME_ARENA_RESERVE_SIZE)) {
+    return false;
+  }
+  memory->permanent.name = "permanent";
+  memory->session.name = "session";
+  memory->frame[0].name = "frame 0";
+  memory->frame[1].name = "frame 1";
+  return true;
+}
+
+void ReleaseGameMemory(GameMemory *memory) {
+  arena_release(&memory->permanent);
+  arena_release(&memory->session);
+  arena_release(&memory->frame[0]);
+  arena_release(&memory->frame[1]);
+}
+
+Arena *FrameArena(GameMemory *memory) {
+  return &memory->frame[memory->frameIndex];
+}
+
+// Flips to the other frame arena and empties it - what it held is two frames
+// old now
+void BeginFrameMemory(GameMemory *memory) {
+  memory->frameIndex ^= 1;
+  arena_free_all(FrameArena(memory));
+}
+
+// Drops everything from the previous game in one reset and starts a fresh
+// World at the front of the session arena. Nothing is spawned yet - the
+// chunks around the camera are generated from seed on the first tick.
+World *StartSession(GameMemory *memory, uint32_t seed) {
+  arena_free_all(&memory->session);
+  world = arena_alloc_tagged(&memory->session, sizeof(World), arena_tag_world);
+  if (!world) {
+    return NULL;
+  }
+  InitWorld(world);
+  world->seed = seed;
+  if (!chunk_table_init(&world->chunks, &memory->session, 64)) {
+    return NULL;
+  }
+  return world;
+}
+
+//
+// Simulation systems - called once per tick from UpdatePlayState
+//
+
+bool rect_overlaps(Rectangle a, Rectangle b) {
+  return a.x < b.x + b.width && a.x + a.width > b.x && a.y < b.y + b.height &&
+         a.y + a.height > b.y;
+}
+
+Rectangle GetEntityBounds(Entity *entity) {
+  Texture2D *sprite = get_sprite(entity->sprite_id);
+  return (Rectangle){entity->pos.x, entity->pos.y, sprite->width * spriteScale,
+                     sprite->height * spriteScale};
+}
+
+// The world-space rectangle the camera shows (rotation is always 0)
+Rectangle GetCameraView(World *world) {
+  Camera2D *camera = &world->camera;
+  return (Rectangle){camera->target.x - camera->offset.x / camera->zoom,
+                     camera->target.y - camera->offset.y / camera->zoom,
+                     world->screenWidth / camera->zoom,
+                     world->screenHeight / camera->zoom};
+}
+
+// Returns false once the player has run out of energy
+bool UpdateClock(World *world, float deltaT) {
+  const float defaultFatigueRate = 1;
+
+  if (world->energy <= 0) {
+    return false;
+  }
+
+  // TODO: maybe make the clock only update every 5 or ten minutes like in
+  // SDV 1 seconds = 1 minute, 24 minutes in game is a 24 hour day
+  const float deltaTScale = 1;
+  world->timeElapsed += deltaT;
+  if (world->timeElapsed >= deltaTScale) {
+    world->timeElapsed = 0;
+    world->timeInMinutes += 1;
+    world->energy -= defaultFatigueRate;
+  }
+  if (world->timeInMinutes >= (60 * 24)) {
+    world->dayCount += 1;
+    world->timeInMinutes = 0;
+  }
+  return true;
+}
+
+void UpdatePlayerMovement(World *world, Vector2 movement, float deltaT) {
+  const float playerSpeed = 300;
+
+  movement = Vector2Normalize(movement);
+  movement = Vector2Scale(movement, deltaT * playerSpeed);
+
+  world->player->pos = Vector2Add(world->player->pos, movement);
+
+  if (movement.x != 0) {
+    world->playerFacingLeft = movement.x < 0;
+  }
+  AnimClipId clip = clip_none;
+  if (movement.x != 0 || movement.y != 0) {
+    clip = world->playerFacingLeft ? clip_player_walk_left
+                                   : clip_player_walk_right;
+  } else if (world->playerFacingLeft) {
+    clip = clip_player_idle_left;
+  }
+  entity_set_clip(world->player, clip, 0);
+}
+
+// Damages every destroyable entity under the cursor tile
+void UpdateHarvest(World *world, Rectangle mouseRectangle) {
+  for (int i = 0; i < world->entityHighWater; i++) {
+    Entity *existing_entity = &world->entities[i];
+    if (!existing_entity->is_valid ||
+        !existing_entity->is_destroyable_world_item) {
+      continue;
+    }
+
+    // Check if point is inside rectangle
+    // TODO: instead - check if the mouse tile is the same as the entity's
+    // tile
+    if (!rect_overlaps(mouseRectangle, GetEntityBounds(existing_entity))) {
+      continue;
+    }
+
+    existing_entity->health -= 1;
+    world_mark_chunk_modified(existing_entity);
+    if (existing_entity->health <= 0) {
+      entity_destroy(existing_entity);
+      if (existing_entity->archetype == arch_weed) {
+        SetupItemWood(existing_entity->pos);
+      } else if (existing_entity->archetype == arch_berry_bush) {
+        SetupItemBerry(existing_entity->pos);
+      }
+    }
+  }
+}
+
+void UpdatePickup(World *world) {
+  for (int i = 0; i < world->entityHighWater; i++) {
+    Entity *existing_entity = &world->entities[i];
+    if (existing_entity->is_valid && existing_entity->is_item &&
+        fabs(Vector2Distance(world->player->pos, existing_entity->pos)) <
+            playerPickupRadius) {
+      entity_destroy(existing_entity);
+      world->inventory[existing_entity->archetype] += 1;
+    }
+  }
+}
@@ -0,0 +1,128 @@
+//
+// World generation
+//
+// The map has no edge. Each chunk is populated the first time the camera
+// comes near it, from the World's seed and the chunk's coordinate alone, so
+// a seed always makes the same world whatever order it's explored in and
+// starting a game only pays for the chunks on screen. The terrain itself is
+// GroundTileAt (tilemap.c) - this places resources on top of it.
+//
+
+// Chunks this far from the camera's chunk are generated - 1 is the 3x3
+// around it, which keeps generation off screen while half the view is
+// narrower than a chunk
+#define WORLDGEN_RADIUS_CHUNKS 1
+
+#define WORLDGEN_SALT_GROWTH 0x6e0a
+#define WORLDGEN_SALT_ROLL 0x7a11
+
+// Lush areas grow more weeds and are the only place berry bushes grow
+const float worldgenGrowthScale = 1.0f / 12;
+const float worldgenBushGrowth = 0.6f;
+// Chances per tile out of 1000
+const int worldgenRockChance = 5;
+const int worldgenDirtRockChance = 40;
+const int worldgenBushChance = 12;
+const int worldgenWeedChance = 90; // at full growth
+// Nothing spawns on top of the player
+const float worldgenSpawnClearance = 3 * TILE_WIDTH;
+
+// Fills in data's tiles and spawns from its seed and coord
+void GenerateChunkData(ChunkData *data) {
+  uint32_t seed = data->seed;
+  int originX = data->coord.x * CHUNK_TILES;
+  int originY = data->coord.y * CHUNK_TILES;
+  data->spawnCount = 0;
+  for (int y = 0; y < CHUNK_TILES; y++) {
+    int tileY = originY + y;
+    unsigned char *row = &data->tiles[y * CHUNK_TILES];
+    GroundTileRow(seed, originX, tileY, CHUNK_TILES, row);
+    float growthRow[CHUNK_TILES];
+    fbm_noise_row(seed ^ WORLDGEN_SALT_GROWTH, originX, tileY,
+                  worldgenGrowthScale, CHUNK_TILES, 2, growthRow);
+    for (int x = 0; x < CHUNK_TILES; x++) {
+      int tileX = originX + x;
+      GroundTile ground = row[x];
+      if (ground == ground_water) {
+        continue;
+      }
+
+      float growth = growthRow[x];
+      int rocks = ground == ground_dirt ? worldgenDirtRockChance
+                                        : worldgenRockChance;
+      int bushes = growth > worldgenBushGrowth ? worldgenBushChance : 0;
+      int weeds = (int)(growth * worldgenWeedChance);
+      int roll = ground_hash(tileX, tileY, seed ^ WORLDGEN_SALT_ROLL) % 1000;
+      EntityArchetype archetype = arch_nil;
+      if (roll < rocks) {
+        archetype = arch_rock;
+      } else if (roll < rocks + bushes) {
+        archetype = arch_berry_bush;
+      } else if (roll < rocks + bushes + weeds) {
+        archetype = arch_weed;
+      }
+      if (archetype != arch_nil) {
+        data->spawns[data->spawnCount++] = (ChunkSpawn){archetype, x, y};
+      }
+    }
+  }
+}
+
+// Main thread - puts a generated chunk's entities into the World
+void SpawnChunkData(World *world, ChunkData *data) {
+  int originX = data->coord.x * CHUNK_TILES;
+  int originY = data->coord.y * CHUNK_TILES;
+  for (int i = 0; i < data->spawnCount; i++) {
+    ChunkSpawn spawn = data->spawns[i];
+    Vector2 pos = v2(tile_pos_to_world_pos(originX + spawn.x),
+                     tile_pos_to_world_pos(originY + spawn.y));
+    if (Vector2Distance(pos, world->player->pos) < worldgenSpawnClearance) {
+      continue;
+    }
+    switch (spawn.archetype) {
+    case arch_rock:
+      SetupRock(pos);
+      break;
+    case arch_berry_bush:
+      SetupBerryBush(pos);
+      break;
+    case arch_weed:
+      SetupWeed(pos);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+// Generates and spawns a chunk right away on this thread
+void GenerateChunk(World *world, ChunkCoord coord) {
+  ChunkData data;
+  data.coord = coord;
+  data.seed = world->seed;
+  GenerateChunkData(&data);
+  SpawnChunkData(world, &data);
+}
+
+// Synchronous version of the streamer (streaming.c) - generates any chunk
+// near the camera that hasn't been yet. Returns how many were generated.
+int UpdateWorldGen(World *world) {
+  ChunkCoord center = chunk_of(world->camera.target);
+  int generated = 0;
+  for (int dy = -WORLDGEN_RADIUS_CHUNKS; dy <= WORLDGEN_RADIUS_CHUNKS; dy++) {
+    for (int dx = -WORLDGEN_RADIUS_CHUNKS; dx <= WORLDGEN_RADIUS_CHUNKS;
+         dx++) {
+      ChunkCoord coord = {center.x + dx, center.y + dy};
+      ChunkInfo *info = chunk_table_put(&world->chunks, coord);
+      if (!info) {
+        return generated; // out of session memory - try again next tick
+      }
+      if (info->state == chunk_unloaded) {
+        GenerateChunk(world, coord);
+        info->state = chunk_loaded;
+        generated++;
+      }
+    }
+  }
+  return generated;
+}
@@ -0,0 +1,484 @@
+//
+// Performance regression gate
+//
+// Compares one or more bench/bench.c JSON outputs against a committed
+// baseline. Every numeric leaf is flattened to a dotted path (eg.
+// "scenes.rocks_weeds_10k.ns_per_entity.harvest") and the median across the
+// runs is checked against the baseline with a per-metric tolerance. Exits
+// non-zero if any metric regressed.
+//
+//   bench_compare bench/baseline.json run1.json [run2.json ...]
+//   bench_compare --update bench/baseline.json run1.json [run2.json ...]
+//   bench_compare --update --only rewind.,save. bench/baseline.json run1.json
+//
+// --update rewrites the baseline from the medians, keeping its tolerances.
+// With --only it rewrites just the metrics under the comma separated path
+// prefixes and leaves the rest as they were, so a change re-baselines the
+// numbers it meant to move and nothing else.
+//
+// The baseline is itself flat:
+//   {"tolerance": {"default": 0.25, "ns_per_entity.clock": 4.0},
+//    "metrics": {"scenes.rocks_weeds_1k.ticks_per_sec": 501347.0}}
+// A tolerance applies to every metric whose path ends with its key, longest
+// match wins, and is the allowed fractional slowdown.
+//
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_METRICS 1024
+#define MAX_RUNS 64
+#define MAX_PATH 256
+#define DEFAULT_TOLERANCE 0.25
+
+typedef struct Metric {
+  char path[MAX_PATH];
+  double value;
+} Metric;
+
+typedef struct MetricList {
+  Metric metrics[MAX_METRICS];
+  int count;
+} MetricList;
+
+Metric *find_metric(MetricList *list, char *path) {
+  for (int i = 0; i < list->count; i++) {
+    if (strcmp(list->metrics[i].path, path) == 0) {
+      return &list->metrics[i];
+    }
+  }
+  return NULL;
+}
+
+//
+// Minimal JSON reader - only keeps numbers, everything else is skipped
+//
+
+typedef struct Parser {
+  char *at;
+  char *file;
+  bool failed;
+} Parser;
+
+void parse_error(Parser *p, char *message) {
+  if (!p->failed) {
+    fprintf(stderr, "%s: %s near '%.20s'\n", p->file, message, p->at);
+  }
+  p->failed = true;
+}
+
+void skip_space(Parser *p) {
+  while (*p->at == ' ' || *p->at == '\n' || *p->at == '\r' ||
+         *p->at == '\t') {
+    p->at++;
+  }
+}
+
+// Copies the string at p->at into out (truncating) and moves past it
+void parse_string(Parser *p, char *out, size_t out_len) {
+  size_t len = 0;
+  if (*p->at != '"') {
+    parse_error(p, "expected string");
+    return;
+  }
+  p->at++;
+  while (*p->at && *p->at != '"') {
+    if (*p->at == '\\' && p->at[1]) {
+      p->at++;
+    }
+    if (out && len + 1 < out_len) {
+      out[len++] = *p->at;
+    }
+    p->at++;
+  }
+  if (*p->at != '"') {
+    parse_error(p, "unterminated string");
+    return;
+  }
+  p->at++;
+  if (out) {
+    out[len] = 0;
+  }
+}
+
+void parse_value(Parser *p, MetricList *list, char *path);
+
+void join_path(Parser *p, char *out, char *prefix, char *key) {
+  int len = prefix[0] ? snprintf(out, MAX_PATH, "%s.%s", prefix, key)
+                      : snprintf(out, MAX_PATH, "%s", key);
+  if (len >= MAX_PATH) {
+    parse_error(p, "path too long");
+  }
+}
+
+void parse_object(Parser *p, MetricList *list, char *path) {
+  p->at++; // {
+  skip_space(p);
+  if (*p->at == '}') {
+    p->at++;
+    return;
+  }
+  while (!p->failed) {
+    char key[MAX_PATH];
+    char child[MAX_PATH];
+    skip_space(p);
+    parse_string(p, key, sizeof(key));
+    skip_space(p);
+    if (*p->at != ':') {
+      parse_error(p, "expected ':'");
+      return;
+    }
+    p->at++;
+    join_path(p, child, path, key);
+    parse_value(p, list, child);
+    skip_space(p);
+    if (*p->at == ',') {
+      p->at++;
+    } else if (*p->at == '}') {
+      p->at++;
+      return;
+    } else {
+      parse_error(p, "expected ',' or '}'");
+    }
+  }
+}
+
+void parse_array(Parser *p, MetricList *list, char *path) {
+  p->at++; // [
+  skip_space(p);
+  if (*p->at == ']') {
+    p->at++;
+    return;
+  }
+  for (int index = 0; !p->failed; index++) {
+    char key[16];
+    char child[MAX_PATH];
+    snprintf(key, sizeof(key), "%d", index);
+    join_path(p, child, path, key);
+    parse_value(p, list, child);
+    skip_space(p);
+    if (*p->at == ',') {
+      p->at++;
+    } else if (*p->at == ']') {
+      p->at++;
+      return;
+    } else {
+      parse_error(p, "expected ',' or ']'");
+    }
+  }
+}
+
+void parse_value(Parser *p, MetricList *list, char *path) {
+  skip_space(p);
+  if (*p->at == '{') {
+    parse_object(p, list, path);
+  } else if (*p->at == '[') {
+    parse_array(p, list, path);
+  } else if (*p->at == '"') {
+    parse_string(p, NULL, 0);
+  } else if (strncmp(p->at, "true", 4) == 0 ||
+             strncmp(p->at, "null", 4) == 0) {
+    p->at += 4;
+  } else if (strncmp(p->at, "false", 5) == 0) {
+    p->at += 5;
+  } else {
+    char *end;
+    double value = strtod(p->at, &end);
+    if (end == p->at) {
+      parse_error(p, "expected value");
+      return;
+    }
+    p->at = end;
+    if (list->count >= MAX_METRICS) {
+      parse_error(p, "too many metrics");
+      return;
+    }
+    Metric *metric = &list->metrics[list->count++];
+    snprintf(metric->path, MAX_PATH, "%s", path);
+    metric->value = value;
+  }
+}
+
+bool load_metrics(char *file, MetricList *list) {
+  FILE *f = fopen(file, "rb");
+  if (!f) {
+    fprintf(stderr, "%s: could not open\n", file);
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char *text = malloc(size + 1);
+  size_t read = fread(text, 1, size, f);
+  text[read] = 0;
+  fclose(f);
+
+  Parser p = {.at = text, .file = file};
+  list->count = 0;
+  parse_value(&p, list, "");
+  free(text);
+  return !p.failed;
+}
+
+//
+// Comparison
+//
+
+int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+bool ends_with(char *s, char *suffix) {
+  size_t s_len = strlen(s);
+  size_t suffix_len = strlen(suffix);
+  return suffix_len <= s_len && strcmp(s + s_len - suffix_len, suffix) == 0 &&
+         (suffix_len == s_len || s[s_len - suffix_len - 1] == '.');
+}
+
+bool has_suffix(char *s, char *suffix) {
+  size_t s_len = strlen(s);
+  size_t suffix_len = strlen(suffix);
+  return suffix_len <= s_len && strcmp(s + s_len - suffix_len, suffix) == 0;
+}
+
+// Printed for comparison only - libc's malloc and sprintf and the linear
+// scans the hash map is measured against aren't our code to gate
+char *reference_metrics[] = {"malloc", "_linear_", "stack_sprintf"};
+
+// Only timings are gated - counts like "entities" and "ticks" are config
+bool is_timing(char *path, bool *higher_is_better) {
+  for (size_t i = 0;
+       i < sizeof(reference_metrics) / sizeof(reference_metrics[0]); i++) {
+    if (strstr(path, reference_metrics[i])) {
+      return false;
+    }
+  }
+  if (strstr(path, "per_sec") || strstr(path, "gb_per_s")) {
+    *higher_is_better = true;
+    return true;
+  }
+  if (strstr(path, "ns_per") || has_suffix(path, "_ns") ||
+      has_suffix(path, "_us") || has_suffix(path, "_ms")) {
+    *higher_is_better = false;
+    return true;
+  }
+  return false;
+}
+
+double tolerance_for(MetricList *baseline, char *metric_path) {
+  double tolerance = DEFAULT_TOLERANCE;
+  size_t best = 0;
+  for (int i = 0; i < baseline->count; i++) {
+    char *path = baseline->metrics[i].path;
+    if (strncmp(path, "tolerance.", 10) != 0) {
+      continue;
+    }
+    char *key = path + 10;
+    if (strcmp(key, "default") == 0 && best == 0) {
+      tolerance = baseline->metrics[i].value;
+    } else if (ends_with(metric_path, key) && strlen(key) > best) {
+      tolerance = baseline->metrics[i].value;
+      best = strlen(key);
+    }
+  }
+  return tolerance;
+}
+
+// Median of every run's value for each path seen in the first run
+void median_runs(MetricList *runs, int run_count, MetricList *out) {
+  out->count = 0;
+  for (int i = 0; i < runs[0].count; i++) {
+    double values[MAX_RUNS];
+    int count = 0;
+    for (int r = 0; r < run_count; r++) {
+      Metric *m = find_metric(&runs[r], runs[0].metrics[i].path);
+      if (m) {
+        values[count++] = m->value;
+      }
+    }
+    qsort(values, count, sizeof(double), compare_doubles);
+    Metric *median = &out->metrics[out->count++];
+    snprintf(median->path, MAX_PATH, "%s", runs[0].metrics[i].path);
+    median->value = count % 2 ? values[count / 2]
+                              : (values[count / 2 - 1] + values[count / 2]) / 2;
+  }
+}
+
+// Whether path starts with one of the comma separated prefixes in only
+bool in_only(char *path, char *only) {
+  while (*only) {
+    size_t len = strcspn(only, ",");
+    if (len && strncmp(path, only, len) == 0) {
+      return true;
+    }
+    only += len;
+    if (*only == ',') {
+      only++;
+    }
+  }
+  return false;
+}
+
+void write_metric(FILE *f, bool *first, char *path, double value) {
+  fprintf(f, "%s\n    \"%s\": %.6g", *first ? "" : ",", path, value);
+  *first = false;
+}
+
+bool write_baseline(char *file, MetricList *baseline, MetricList *medians,
+                    char *only) {
+  FILE *f = fopen(file, "wb");
+  if (!f) {
+    fprintf(stderr, "%s: could not write\n", file);
+    return false;
+  }
+  fprintf(f, "{\n  \"tolerance\": {");
+  bool first = true;
+  for (int i = 0; i < baseline->count; i++) {
+    if (strncmp(baseline->metrics[i].path, "tolerance.", 10) == 0) {
+      fprintf(f, "%s\n    \"%s\": %g", first ? "" : ",",
+              baseline->metrics[i].path + 10, baseline->metrics[i].value);
+      first = false;
+    }
+  }
+  if (first) {
+    fprintf(f, "\n    \"default\": %g", DEFAULT_TOLERANCE);
+  }
+  fprintf(f, "\n  },\n  \"metrics\": {");
+  first = true;
+  bool higher_is_better;
+  if (only) {
+    // the old numbers in their old order, the selected ones re-measured
+    // (or dropped if the bench doesn't print them anymore)
+    for (int i = 0; i < baseline->count; i++) {
+      char *path = baseline->metrics[i].path;
+      if (strncmp(path, "metrics.", 8) != 0) {
+        continue;
+      }
+      path += 8;
+      if (!in_only(path, only)) {
+        write_metric(f, &first, path, baseline->metrics[i].value);
+        continue;
+      }
+      Metric *current = find_metric(medians, path);
+      if (current && is_timing(path, &higher_is_better)) {
+        write_metric(f, &first, path, current->value);
+      }
+    }
+  }
+  for (int i = 0; i < medians->count; i++) {
+    char *path = medians->metrics[i].path;
+    if (!is_timing(path, &higher_is_better)) {
+      continue;
+    }
+    if (only) {
+      // only new metrics under the prefixes are left to add
+      char key[MAX_PATH + 8];
+      snprintf(key, sizeof(key), "metrics.%s", path);
+      if (!in_only(path, only) || find_metric(baseline, key)) {
+        continue;
+      }
+    }
+    write_metric(f, &first, path, medians->metrics[i].value);
+  }
+  fprintf(f, "\n  }\n}\n");
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  bool update = false;
+  char *only = NULL;
+  int arg = 1;
+  if (arg < argc && strcmp(argv[arg], "--update") == 0) {
+    update = true;
+    arg++;
+    if (arg + 1 < argc && strcmp(argv[arg], "--only") == 0) {
+      only = argv[arg + 1];
+      arg += 2;
+    }
+  }
+  if (argc - arg < 2) {
+    fprintf(stderr,
+            "usage: %s [--update [--only prefix,...]] baseline.json "
+            "run.json [run.json ...]\n",
+            argv[0]);
+    return 2;
+  }
+
+  static MetricList baseline;
+  static MetricList runs[MAX_RUNS];
+  static MetricList medians;
+  char *baseline_file = argv[arg++];
+  int run_count = argc - arg;
+  if (run_count > MAX_RUNS) {
+    run_count = MAX_RUNS;
+  }
+
+  bool have_baseline = load_metrics(baseline_file, &baseline);
+  if (!have_baseline && !update) {
+    return 2;
+  }
+  for (int r = 0; r < run_count; r++) {
+    if (!load_metrics(argv[arg + r], &runs[r])) {
+      return 2;
+    }
+  }
+  median_runs(runs, run_count, &medians);
+
+  if (update) {
+    if (!have_baseline) {
+      baseline.count = 0;
+    }
+    if (!write_baseline(baseline_file, &baseline, &medians, only)) {
+      return 2;
+    }
+    printf("wrote %s%s%s from the median of %d run(s)\n", baseline_file,
+           only ? " under " : "", only ? only : "", run_count);
+    return 0;
+  }
+
+  int regressions = 0;
+  int checked = 0;
+  for (int i = 0; i < baseline.count; i++) {
+    char *path = baseline.metrics[i].path;
+    if (strncmp(path, "metrics.", 8) != 0) {
+      continue;
+    }
+    path += 8;
+    double expected = baseline.metrics[i].value;
+    Metric *current = find_metric(&medians, path);
+    bool higher_is_better;
+    if (!is_timing(path, &higher_is_better)) {
+      continue;
+    }
+    if (!current) {
+      printf("MISSING   %s\n", path);
+      regressions++;
+      continue;
+    }
+
+    double tolerance = tolerance_for(&baseline, path);
+    // slowdown > 1 means worse than the baseline
+    double slowdown = higher_is_better ? expected / current->value
+                                       : current->value / expected;
+    char *status = "ok";
+    if (slowdown > 1.0 + tolerance) {
+      status = "REGRESSED";
+      regressions++;
+    } else if (slowdown < 1.0 / (1.0 + tolerance)) {
+      status = "improved";
+    }
+    printf("%-9s %-52s %12.3f -> %12.3f (%+6.1f%%, tol %.0f%%)\n", status,
+           path, expected, current->value, (slowdown - 1.0) * 100.0,
+           tolerance * 100.0);
+    checked++;
+  }
+
+  printf("%d metric(s) checked over %d run(s), %d regression(s)\n", checked,
+         run_count, regressions);
+  return regressions ? 1 : 0;
+}